@@ -18,6 +18,8 @@ void bidirectional_stream_copy(Socket &socket) {
     FileDescriptor _output{STDOUT_FILENO};
     ByteStream _outbound{buffer_size};
     ByteStream _inbound{buffer_size};
+    _outbound.set_watermarks(buffer_size / 2, buffer_size);
+    _inbound.set_watermarks(buffer_size / 2, buffer_size);
     bool _outbound_shutdown{false};
     bool _inbound_shutdown{false};
 
@@ -30,21 +32,19 @@ void bidirectional_stream_copy(Socket &socket) {
         _input,
         Direction::In,
         [&] {
-            _outbound.write(_input.read(_outbound.remaining_capacity()));
+            _outbound.write_from(_input);
             if (_input.eof()) {
                 _outbound.end_input();
             }
         },
-        [&] { return (not _outbound.error()) and (_outbound.remaining_capacity() > 0) and (not _inbound.error()); },
+        [&] { return (not _outbound.error()) and (_outbound.writable()) and (not _inbound.error()); },
         [&] { _outbound.end_input(); });
 
     // rule 2: read from outbound byte stream into socket
     _eventloop.add_rule(socket,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _outbound.buffer_size());
-                            const size_t bytes_written = socket.write(_outbound.peek_output(bytes_to_write), false);
-                            _outbound.pop_output(bytes_written);
+                            _outbound.read_into(socket, max_copy_length);
                             if (_outbound.eof()) {
                                 socket.shutdown(SHUT_WR);
                                 _outbound_shutdown = true;
@@ -58,21 +58,19 @@ void bidirectional_stream_copy(Socket &socket) {
         socket,
         Direction::In,
         [&] {
-            _inbound.write(socket.read(_inbound.remaining_capacity()));
+            _inbound.write_from(socket);
             if (socket.eof()) {
                 _inbound.end_input();
             }
         },
-        [&] { return (not _inbound.error()) and (_inbound.remaining_capacity() > 0) and (not _outbound.error()); },
+        [&] { return (not _inbound.error()) and (_inbound.writable()) and (not _outbound.error()); },
         [&] { _inbound.end_input(); });
 
     // rule 4: read from inbound byte stream into stdout
     _eventloop.add_rule(_output,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _inbound.buffer_size());
-                            const size_t bytes_written = _output.write(_inbound.peek_output(bytes_to_write), false);
-                            _inbound.pop_output(bytes_written);
+                            _inbound.read_into(_output, max_copy_length);
 
                             if (_inbound.eof()) {
                                 _output.close();
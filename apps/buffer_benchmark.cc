@@ -0,0 +1,66 @@
+#include "buffer.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t packets = 1000000;
+constexpr size_t payload_size = 1400;
+constexpr size_t header_size = 20;
+
+//! Wrap a payload in `depth` headers, one layer at a time, the way each protocol layer
+//! prepends its header to the serialized layer above; then drain it as a partial writer would
+void stack_headers(const size_t depth) {
+    const Buffer payload{string(payload_size, 'x')};
+    const Buffer header{string(header_size, 'h')};
+
+    size_t checksum = 0;
+    const auto first_time = high_resolution_clock::now();
+
+    for (size_t i = 0; i < packets; i++) {
+        BufferList packet{payload};
+        for (size_t layer = 0; layer < depth; layer++) {
+            BufferList outer{header};
+            outer.append(packet);
+            // each layer records the length of everything it encapsulates
+            checksum += outer.size() - packet.size();
+            packet = move(outer);
+        }
+
+        BufferViewList views{packet};
+        while (views.size() > 0) {
+            const size_t chunk = min(views.size(), size_t(512));
+            checksum += views.iovecs().size();
+            views.remove_prefix(chunk);
+        }
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    if (checksum == 0) {
+        throw runtime_error("nothing was stacked");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    cout << fixed << setprecision(1);
+    cout << "Header stacking, depth " << setw(2) << depth << ": " << double(duration) / packets << " ns/packet\n";
+}
+
+int main() {
+    try {
+        for (const size_t depth : {1, 3, 8, 16}) {
+            stack_headers(depth);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t total_bytes = 1ul << 30;
+
+//! Checksum `total_bytes` bytes in `packet_size`-byte packets with the current kernel
+void checksum_packets(const string &kernel_name, const size_t packet_size) {
+    string packet(packet_size, 0);
+    auto rd = get_random_generator();
+    generate(packet.begin(), packet.end(), [&] { return rd(); });
+
+    const size_t packets = total_bytes / packet_size;
+    uint32_t accumulated = 0;
+    const auto first_time = high_resolution_clock::now();
+
+    for (size_t i = 0; i < packets; i++) {
+        InternetChecksum check{uint32_t(i)};
+        check.add(packet);
+        accumulated += check.value();
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    if (accumulated == 0) {
+        throw runtime_error("checksums were all zero");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    const double gigabytes_per_second = double(packets * packet_size) / double(duration);
+
+    cout << fixed << setprecision(2);
+    cout << setw(8) << kernel_name << ", " << setw(5) << packet_size << "-byte packets: " << setw(6)
+         << double(duration) / packets << " ns/packet, " << setw(6) << gigabytes_per_second << " GB/s\n";
+}
+
+//! Copy and checksum `total_bytes` bytes in `packet_size`-byte packets, either in one pass or in two
+void copy_and_checksum_packets(const string &kernel_name, const size_t packet_size, const bool fused) {
+    string packet(packet_size, 0), copy(packet_size, 0);
+    auto rd = get_random_generator();
+    generate(packet.begin(), packet.end(), [&] { return rd(); });
+
+    const size_t packets = total_bytes / packet_size;
+    uint32_t accumulated = 0;
+    const auto first_time = high_resolution_clock::now();
+
+    for (size_t i = 0; i < packets; i++) {
+        InternetChecksum check{uint32_t(i)};
+        if (fused) {
+            check.add_copy(copy.data(), packet);
+        } else {
+            memcpy(copy.data(), packet.data(), packet_size);
+            check.add(copy);
+        }
+        accumulated += check.value() + uint8_t(copy[i % packet_size]);
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    if (accumulated == 0) {
+        throw runtime_error("checksums were all zero");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    cout << fixed << setprecision(2);
+    cout << setw(8) << kernel_name << ", " << setw(5) << packet_size << "-byte packets, "
+         << (fused ? "copy+checksum fused:    " : "copy, then checksum:    ") << setw(6) << double(duration) / packets
+         << " ns/packet\n";
+}
+
+int main() {
+    try {
+        const pair<InternetChecksum::Kernel, string> kernels[] = {{InternetChecksum::Kernel::Portable, "portable"},
+                                                                  {InternetChecksum::Kernel::SSE2, "SSE2"},
+                                                                  {InternetChecksum::Kernel::AVX2, "AVX2"}};
+        for (const auto &[kernel, name] : kernels) {
+            if (not InternetChecksum::supported(kernel)) {
+                cout << name << ": not supported on this machine\n";
+                continue;
+            }
+            InternetChecksum::use(kernel);
+            for (const size_t packet_size : {20, 40, 576, 1460, 9000}) {
+                checksum_packets(name, packet_size);
+            }
+            for (const size_t packet_size : {1460, 9000}) {
+                copy_and_checksum_packets(name, packet_size, false);
+                copy_and_checksum_packets(name, packet_size, true);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
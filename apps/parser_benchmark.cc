@@ -0,0 +1,168 @@
+#include "ipv4_header.hh"
+#include "parser.hh"
+#include "tcp_header.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t headers = 10000000;
+
+//! \name The per-field path: one NetParser or NetUnparser call per header field
+//!@{
+
+void parse_fields(NetParser &p, TCPHeader &header) {
+    header.sport = p.u16();
+    header.dport = p.u16();
+    header.seqno = WrappingInt32{p.u32()};
+    header.ackno = WrappingInt32{p.u32()};
+    header.doff = p.u8() >> 4;
+    const uint8_t fl_b = p.u8();
+    header.urg = static_cast<bool>(fl_b & 0b0010'0000);
+    header.ack = static_cast<bool>(fl_b & 0b0001'0000);
+    header.psh = static_cast<bool>(fl_b & 0b0000'1000);
+    header.rst = static_cast<bool>(fl_b & 0b0000'0100);
+    header.syn = static_cast<bool>(fl_b & 0b0000'0010);
+    header.fin = static_cast<bool>(fl_b & 0b0000'0001);
+    header.win = p.u16();
+    header.cksum = p.u16();
+    header.uptr = p.u16();
+}
+
+string serialize_fields(const TCPHeader &header) {
+    string ret = BufferPool::take();
+    NetUnparser::u16(ret, header.sport);
+    NetUnparser::u16(ret, header.dport);
+    NetUnparser::u32(ret, header.seqno.raw_value());
+    NetUnparser::u32(ret, header.ackno.raw_value());
+    NetUnparser::u8(ret, header.doff << 4);
+    const uint8_t fl_b = (header.urg ? 0b0010'0000 : 0) | (header.ack ? 0b0001'0000 : 0) |
+                         (header.psh ? 0b0000'1000 : 0) | (header.rst ? 0b0000'0100 : 0) |
+                         (header.syn ? 0b0000'0010 : 0) | (header.fin ? 0b0000'0001 : 0);
+    NetUnparser::u8(ret, fl_b);
+    NetUnparser::u16(ret, header.win);
+    NetUnparser::u16(ret, header.cksum);
+    NetUnparser::u16(ret, header.uptr);
+    return ret;
+}
+
+void parse_fields(NetParser &p, IPv4Header &header) {
+    const uint8_t first_byte = p.u8();
+    header.ver = first_byte >> 4;
+    header.hlen = first_byte & 0x0f;
+    header.tos = p.u8();
+    header.len = p.u16();
+    header.id = p.u16();
+    const uint16_t fo_val = p.u16();
+    header.df = static_cast<bool>(fo_val & 0x4000);
+    header.mf = static_cast<bool>(fo_val & 0x2000);
+    header.offset = fo_val & 0x1fff;
+    header.ttl = p.u8();
+    header.proto = p.u8();
+    header.cksum = p.u16();
+    header.src = p.u32();
+    header.dst = p.u32();
+}
+
+string serialize_fields(const IPv4Header &header) {
+    string ret = BufferPool::take();
+    NetUnparser::u8(ret, (header.ver << 4) | (header.hlen & 0xf));
+    NetUnparser::u8(ret, header.tos);
+    NetUnparser::u16(ret, header.len);
+    NetUnparser::u16(ret, header.id);
+    NetUnparser::u16(ret, (header.df ? 0x4000 : 0) | (header.mf ? 0x2000 : 0) | (header.offset & 0x1fff));
+    NetUnparser::u8(ret, header.ttl);
+    NetUnparser::u8(ret, header.proto);
+    NetUnparser::u16(ret, header.cksum);
+    NetUnparser::u32(ret, header.src);
+    NetUnparser::u32(ret, header.dst);
+    return ret;
+}
+//!@}
+
+//! Time `headers` calls of `fn`, and report the cost of each
+template <typename Function>
+void time_headers(const string &description, Function &&fn) {
+    size_t checksum = 0;
+    const auto first_time = high_resolution_clock::now();
+
+    for (size_t i = 0; i < headers; i++) {
+        checksum += fn(i);
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    if (checksum == 0) {
+        throw runtime_error("nothing was decoded");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    cout << fixed << setprecision(1);
+    cout << setw(34) << description << ": " << setw(5) << double(duration) / headers << " ns/header\n";
+}
+
+template <typename Header>
+void benchmark(const string &name, const Header &sample) {
+    const Buffer wire{sample.serialize()};
+
+    time_headers(name + " parse, per field", [&](const size_t) {
+        Header header;
+        NetParser p{wire};
+        parse_fields(p, header);
+        return header.cksum;
+    });
+    time_headers(name + " parse, fixed layout", [&](const size_t) {
+        Header header;
+        NetParser p{wire};
+        header.parse(p);
+        return header.cksum;
+    });
+
+    time_headers(name + " serialize, per field", [&](const size_t i) {
+        Header header = sample;
+        header.cksum = i;
+        string ret = serialize_fields(header);
+        const size_t size = ret.size();
+        BufferPool::recycle(move(ret));
+        return size;
+    });
+    time_headers(name + " serialize, fixed layout", [&](const size_t i) {
+        Header header = sample;
+        header.cksum = i;
+        string ret = header.serialize();
+        const size_t size = ret.size();
+        BufferPool::recycle(move(ret));
+        return size;
+    });
+}
+
+int main() {
+    try {
+        TCPHeader tcp;
+        tcp.sport = 1234;
+        tcp.dport = 80;
+        tcp.seqno = WrappingInt32{0x12345678};
+        tcp.ack = true;
+        tcp.win = 65000;
+        tcp.cksum = 0xbeef;
+        benchmark("TCP", tcp);
+
+        IPv4Header ip;
+        ip.len = 1500;
+        ip.src = 0x0a000001;
+        ip.dst = 0x0a000002;
+        ip.cksum = 0xbeef;
+        benchmark("IPv4", ip);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
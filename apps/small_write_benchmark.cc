@@ -0,0 +1,108 @@
+#include "tcp_connection.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t len = 4 * 1024 * 1024;
+constexpr size_t writes_per_round_trip = 100;
+
+//! Move every segment x has sent to y, counting those that carry data
+size_t move_segments(TCPConnection &x, TCPConnection &y) {
+    size_t data_segments = 0;
+    while (not x.segments_out().empty()) {
+        data_segments += x.segments_out().front().payload().size() != 0;
+        y.segment_received(move(x.segments_out().front()));
+        x.segments_out().pop();
+    }
+    return data_segments;
+}
+
+//! \param[in] write_size bytes the application hands the connection per write
+//! \param[in] nodelay send each write at once, rather than coalescing with Nagle's algorithm
+//! \details The application makes `writes_per_round_trip` writes, then the segments cross in each direction,
+//! so that each pass of the loop is one round trip.
+void main_loop(const size_t write_size, const bool nodelay) {
+    TCPConfig config;
+    config.nodelay = nodelay;
+    TCPConnection x{config}, y{config};
+
+    const string chunk(write_size, 'x');
+    size_t written = 0;
+    size_t received = 0;
+    size_t data_segments = 0;
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+
+    const auto first_time = high_resolution_clock::now();
+
+    auto loop = [&] {
+        // the application's small writes
+        for (size_t i = 0; i < writes_per_round_trip and written < len; i++) {
+            const auto n = x.write(chunk.substr(0, min(write_size, len - written)));
+            if (n == 0) {
+                break;
+            }
+            written += n;
+        }
+
+        if (written == len and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        data_segments += move_segments(x, y);
+        move_segments(y, x);
+
+        received += y.inbound_stream().read(y.inbound_stream().buffer_size()).size();
+
+        x.tick(1);
+        y.tick(1);
+    };
+
+    while (not y.inbound_stream().eof()) {
+        loop();
+    }
+
+    if (received != len) {
+        throw runtime_error("bytes sent vs. received don't match");
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    const auto packets_per_second = data_segments * 1e9 / double(duration);
+    const auto bytes_per_packet = double(len) / data_segments;
+    const auto megabytes_per_second = len * 1e3 / double(duration);
+
+    cout << fixed << setprecision(2);
+    cout << setw(4) << write_size << "-byte writes, " << (nodelay ? "nodelay:" : "Nagle:  ") << setw(8)
+         << data_segments << " packets, " << setw(7) << bytes_per_packet << " bytes/packet, CPU-limited "
+         << setw(10) << packets_per_second << " packets/s, " << setw(7) << megabytes_per_second << " MB/s\n";
+
+    while (x.active() or y.active()) {
+        loop();
+    }
+}
+
+int main() {
+    try {
+        for (const size_t write_size : {1, 10, 100, 1000}) {
+            main_loop(write_size, true);
+            main_loop(write_size, false);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
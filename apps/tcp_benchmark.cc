@@ -11,9 +11,27 @@ using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+//! Drops a deterministic fraction of segments: every `interval`-th one (none if `interval` is zero)
+class SegmentDropper {
+  private:
+    size_t _interval;
+    size_t _count{0};
+
+  public:
+    explicit SegmentDropper(const size_t interval) : _interval(interval) {}
+
+    bool drop() { return _interval != 0 and ++_count % _interval == 0; }
+};
+
+void move_segments(TCPConnection &x,
+                   TCPConnection &y,
+                   vector<TCPSegment> &segments,
+                   const bool reorder,
+                   SegmentDropper &dropper) {
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        if (not dropper.drop()) {
+            segments.emplace_back(move(x.segments_out().front()));
+        }
         x.segments_out().pop();
     }
     if (reorder) {
@@ -28,9 +46,20 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+//! \param[in] reorder deliver each batch of segments from x to y in reverse order
+//! \param[in] drop_interval drop every `drop_interval`-th segment from x to y (none if zero); each pass of the
+//! loop is then one round trip of one millisecond, so that lost segments cost round trips and timeouts
+//! \param[in] fast_retransmit recover from drops on duplicate acks, rather than waiting for the timer
+void main_loop(const bool reorder, const size_t drop_interval = 0, const bool fast_retransmit = true) {
     TCPConfig config;
+    config.fast_retransmit = fast_retransmit;
+    const bool lossy = drop_interval != 0;
+    if (lossy) {
+        config.adaptive_rto = true;
+    }
     TCPConnection x{config}, y{config};
+    SegmentDropper dropper{drop_interval}, no_drops{0};
+    uint64_t elapsed_ms = 0;
 
     string string_to_send(len, 'x');
     for (auto &ch : string_to_send) {
@@ -52,7 +81,7 @@ void main_loop(const bool reorder) {
         // write input into x
         while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
             const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
-            const auto written = x.write(string(bytes_to_send.str().substr(0, want)));
+            const auto written = x.write(bytes_to_send);
             if (want != written) {
                 throw runtime_error("want = " + to_string(want) + ", written = " + to_string(written));
             }
@@ -66,8 +95,8 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
-        move_segments(y, x, segments, false);
+        move_segments(x, y, segments, reorder, dropper);
+        move_segments(y, x, segments, false, no_drops);
 
         // read output from y
         const auto available_output = y.inbound_stream().buffer_size();
@@ -76,8 +105,10 @@ void main_loop(const bool reorder) {
         }
 
         // time passes
-        x.tick(1000);
-        y.tick(1000);
+        const size_t ms = lossy ? 1 : 1000;
+        x.tick(ms);
+        y.tick(ms);
+        elapsed_ms += ms;
     };
 
     while (not y.inbound_stream().eof()) {
@@ -95,8 +126,14 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    if (lossy) {
+        cout << "1 in " << setw(4) << drop_interval << " segments dropped, fast retransmit "
+             << (fast_retransmit ? "on: " : "off:") << " CPU-limited " << setw(5) << gigabits_per_second
+             << " Gbit/s, " << setw(6) << elapsed_ms << " round trips\n";
+    } else {
+        cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ")
+             << gigabits_per_second << " Gbit/s\n";
+    }
 
     while (x.active() or y.active()) {
         loop();
@@ -107,6 +144,10 @@ int main() {
     try {
         main_loop(false);
         main_loop(true);
+        for (const size_t drop_interval : {1000, 100}) {
+            main_loop(false, drop_interval, false);
+            main_loop(false, drop_interval, true);
+        }
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -54,6 +54,7 @@ static void check_argc(int argc, char **argv, int curr, const char *err) {
 
 static tuple<TCPConfig, FdAdapterConfig, bool, char *> get_config(int argc, char **argv) {
     TCPConfig c_fsm{};
+    c_fsm.adaptive_rto = true;
     FdAdapterConfig c_filt{};
     char *tundev = nullptr;
 
@@ -30,12 +30,38 @@ add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
+add_test(NAME t_strm_reassem_random      COMMAND fsm_stream_reassembler_random)
+add_test(NAME t_strm_reassem_budget      COMMAND fsm_stream_reassembler_budget)
+add_test(NAME t_strm_reassem_single_bitmap      COMMAND fsm_stream_reassembler_single_bitmap)
+add_test(NAME t_strm_reassem_seq_bitmap         COMMAND fsm_stream_reassembler_seq_bitmap)
+add_test(NAME t_strm_reassem_dup_bitmap         COMMAND fsm_stream_reassembler_dup_bitmap)
+add_test(NAME t_strm_reassem_holes_bitmap       COMMAND fsm_stream_reassembler_holes_bitmap)
+add_test(NAME t_strm_reassem_many_bitmap        COMMAND fsm_stream_reassembler_many_bitmap)
+add_test(NAME t_strm_reassem_overlapping_bitmap COMMAND fsm_stream_reassembler_overlapping_bitmap)
+add_test(NAME t_strm_reassem_win_bitmap         COMMAND fsm_stream_reassembler_win_bitmap)
+add_test(NAME t_strm_reassem_cap_bitmap         COMMAND fsm_stream_reassembler_cap_bitmap)
+add_test(NAME t_strm_reassem_random_bitmap      COMMAND fsm_stream_reassembler_random_bitmap)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_storage      COMMAND byte_stream_storage)
+add_test(NAME t_byte_stream_fd           COMMAND byte_stream_fd)
+add_test(NAME t_byte_stream_watermarks   COMMAND byte_stream_watermarks)
+add_test(NAME t_byte_stream_concurrent   COMMAND concurrent_byte_stream)
+add_test(NAME t_buffer_pool              COMMAND buffer_pool)
+add_test(NAME t_buffer_list              COMMAND buffer_list)
+add_test(NAME t_internet_checksum        COMMAND internet_checksum)
+add_test(NAME t_tcp_segment_view         COMMAND tcp_segment_view)
+add_test(NAME t_packet_builder           COMMAND packet_builder)
+add_test(NAME t_tcp_options              COMMAND tcp_options)
+add_test(NAME t_tcp_rtt                  COMMAND tcp_rtt)
+add_test(NAME t_congestion_control       COMMAND congestion_control)
+add_test(NAME t_fast_retransmit          COMMAND fast_retransmit)
+add_test(NAME t_tcp_sack                 COMMAND tcp_sack)
+add_test(NAME t_nagle                    COMMAND nagle)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
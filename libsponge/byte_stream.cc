@@ -1,5 +1,10 @@
 #include "byte_stream.hh"
 
+#include "file_descriptor.hh"
+#include "util.hh"
+
+#include <cstring>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,18 +17,162 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) : _capacity(capacity) {}
+//! \returns the smallest power of two that is at least `capacity` (and at least 1)
+static size_t ring_size_for(const size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    return size;
+}
+
+//! \param[in] capacity the maximum number of bytes the stream buffers at once
+//! \param[in] storage how the buffered bytes are held; Storage::Ring allocates the whole ring up front
+ByteStream::ByteStream(const size_t capacity, const Storage storage)
+    : _storage(storage), _capacity(capacity), _low_watermark(capacity), _high_watermark(capacity) {
+    if (_storage == Storage::Ring) {
+        _ring.resize(ring_size_for(_capacity));
+        _ring_mask = _ring.size() - 1;
+    }
+}
+
+//! \details The caller must make sure that `len` is no more than remaining_capacity().
+void ByteStream::ring_write(const char *data, const size_t len) {
+    const size_t tail = _bytes_written & _ring_mask;
+    const size_t first_part = min(len, _ring.size() - tail);
+    memcpy(_ring.data() + tail, data, first_part);
+    memcpy(_ring.data(), data + first_part, len - first_part);
+}
+
+//! \details The caller must make sure that `len` is no more than buffer_size().
+void ByteStream::ring_peek(char *out, const size_t len) const {
+    const size_t head = _bytes_read & _ring_mask;
+    const size_t first_part = min(len, _ring.size() - head);
+    memcpy(out, _ring.data() + head, first_part);
+    memcpy(out + first_part, _ring.data(), len - first_part);
+}
+
+//! \details The regions point into the ring, and stay valid until the ring is written over.
+size_t ByteStream::ring_regions(const size_t index, const size_t len, array<iovec, 2> &regions) {
+    const size_t start = index & _ring_mask;
+    const size_t first_part = min(len, _ring.size() - start);
+    size_t count = 0;
+    if (first_part > 0) {
+        regions[count++] = {_ring.data() + start, first_part};
+    }
+    if (len > first_part) {
+        regions[count++] = {_ring.data(), len - first_part};
+    }
+    return count;
+}
+
+//! \details Called after `len` > 0 bytes have been added to the buffer.
+void ByteStream::record_write(const size_t len) {
+    _bytes_written += len;
+    if (buffer_size() >= _high_watermark) {
+        _writable = false;
+    }
+}
+
+//! \details Called after `len` > 0 bytes have been removed from the buffer.
+void ByteStream::record_pop(const size_t len) {
+    _bytes_read += len;
+    if (not _writable and buffer_size() <= _low_watermark) {
+        _writable = true;
+    }
+}
+
+//! \param[in] low is the buffer size the reader must drain to before a paused writer is writable again
+//! \param[in] high is the buffer size at which the writer stops being writable (at most the capacity)
+void ByteStream::set_watermarks(const size_t low, const size_t high) {
+    _high_watermark = min(high, _capacity);
+    _low_watermark = min(low, _high_watermark);
+    if (buffer_size() >= _high_watermark) {
+        _writable = false;
+    } else if (buffer_size() <= _low_watermark) {
+        _writable = true;
+    }
+}
+
+bool ByteStream::writable() const { return _writable and remaining_capacity() > 0; }
+
+size_t ByteStream::write(const string &data) { return write(data.data(), data.size()); }
+
+size_t ByteStream::write(const char *data, const size_t len) {
+    size_t written_len = min(remaining_capacity(), len);
+    if (written_len == 0) {
+        return 0;
+    }
+    if (_storage == Storage::Ring) {
+        ring_write(data, written_len);
+    } else {
+        _buffer.push_back(string(data, written_len));
+    }
+    record_write(written_len);
+    return written_len;
+}
+
+//! \details In Storage::Chunked mode, a string that fits completely is moved into the stream
+//! without copying; otherwise only the accepted prefix is copied, so the stream never keeps
+//! a large caller allocation alive for a few bytes. Storage::Ring always copies.
+size_t ByteStream::write(string &&data) {
+    if (_storage == Storage::Ring or data.size() > remaining_capacity()) {
+        return write(static_cast<const string &>(data));
+    }
+    return write(Buffer(move(data)));
+}
 
-size_t ByteStream::write(const string &data) {
+//! \details In Storage::Chunked mode the stream keeps a copy of the Buffer trimmed to the accepted
+//! length, sharing its storage. The caller can drop what was written with Buffer::remove_prefix
+//! and retry the rest later.
+size_t ByteStream::write(Buffer data) {
     size_t written_len = min(remaining_capacity(), data.size());
-    _buffer.push_back(move(string().assign(data.begin(), data.begin() + written_len)));
-    _bytes_written += written_len;
+    if (written_len == 0) {
+        return 0;
+    }
+    if (_storage == Storage::Ring) {
+        ring_write(data.str().data(), written_len);
+    } else {
+        data.remove_suffix(data.size() - written_len);
+        _buffer.push_back(move(data));
+    }
+    record_write(written_len);
+    return written_len;
+}
+
+//! \param[in] fd is the file descriptor to read from; its eof() is set if it has no more bytes
+//! \param[in] max is the largest number of bytes to read
+//! \details In Storage::Ring mode the bytes land directly in the free part of the ring. In
+//! Storage::Chunked mode they are read into a new Buffer, which the stream then keeps.
+size_t ByteStream::write_from(FileDescriptor &fd, const size_t max) {
+    const size_t read_len = min(max, remaining_capacity());
+    if (read_len == 0) {
+        return 0;
+    }
+    if (_storage == Storage::Chunked) {
+        string data;
+        fd.read(data, read_len);
+        return write(Buffer(move(data)));
+    }
+
+    array<iovec, 2> regions{};
+    const size_t count = ring_regions(_bytes_written, read_len, regions);
+    const size_t written_len = fd.readv(regions.data(), count);
+    if (written_len > 0) {
+        record_write(written_len);
+    }
     return written_len;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
     size_t peek_len = min(len, buffer_size());
+    if (_storage == Storage::Ring) {
+        string peek_str(peek_len, 0);
+        ring_peek(peek_str.data(), peek_len);
+        return peek_str;
+    }
+
     string peek_str;
     // Resize the capacity of peek_str
     peek_str.reserve(peek_len);
@@ -41,13 +190,101 @@ string ByteStream::peek_output(const size_t len) const {
     return peek_str;
 }
 
+//! \param[in] len bytes will be viewed from the output side of the buffer
+//! \details In Storage::Ring mode the result has at most two pieces (before and after the wrap point).
+BufferViewList ByteStream::peek_views(const size_t len) const {
+    size_t peek_len = min(len, buffer_size());
+    BufferViewList views;
+    if (_storage == Storage::Ring) {
+        const size_t head = _bytes_read & _ring_mask;
+        const size_t first_part = min(peek_len, _ring.size() - head);
+        if (first_part > 0) {
+            views.append({_ring.data() + head, first_part});
+        }
+        if (peek_len > first_part) {
+            views.append({_ring.data(), peek_len - first_part});
+        }
+        return views;
+    }
+
+    for (const auto &buf : _buffer) {
+        if (peek_len == 0) {
+            break;
+        }
+        const string_view piece = buf.str().substr(0, peek_len);
+        views.append(piece);
+        peek_len -= piece.size();
+    }
+    return views;
+}
+
+//! \param[in] len bytes will be shared from the output side of the buffer
+//! \details In Storage::Chunked mode each piece shares the storage of the Buffer it came from.
+//! The ring is overwritten as the stream advances, so in Storage::Ring mode the bytes are
+//! copied into a single new Buffer (a pooled chunk when they fit in one).
+BufferList ByteStream::peek_buffers(const size_t len) const {
+    size_t peek_len = min(len, buffer_size());
+    if (_storage == Storage::Ring) {
+        string copy = peek_len <= BufferPool::CHUNK_SIZE ? BufferPool::take() : string();
+        copy.resize(peek_len);
+        ring_peek(copy.data(), peek_len);
+        return BufferList(move(copy));
+    }
+
+    BufferList buffers;
+    for (const auto &buf : _buffer) {
+        if (peek_len == 0) {
+            break;
+        }
+        Buffer piece = buf;
+        if (piece.size() > peek_len) {
+            piece.remove_suffix(piece.size() - peek_len);
+        }
+        peek_len -= piece.size();
+        buffers.append(piece);
+    }
+    return buffers;
+}
+
+//! \param[in] len bytes will be viewed from the output side of the buffer
+//! \param[in,out] check has the bytes added to it
+Buffer ByteStream::peek_summed(const size_t len, InternetChecksum &check) const {
+    const size_t peek_len = min(len, buffer_size());
+    if (_storage == Storage::Chunked and (peek_len == 0 or _buffer.front().size() >= peek_len)) {
+        Buffer piece = peek_len == 0 ? Buffer{} : _buffer.front();
+        piece.remove_suffix(piece.size() - peek_len);
+        check.add(piece);
+        return piece;
+    }
+
+    string copy = peek_len <= BufferPool::CHUNK_SIZE ? BufferPool::take() : string();
+    copy.resize(peek_len);
+    if (_storage == Storage::Ring) {
+        const size_t head = _bytes_read & _ring_mask;
+        const size_t first_part = min(peek_len, _ring.size() - head);
+        check.add_copy(copy.data(), {_ring.data() + head, first_part});
+        check.add_copy(copy.data() + first_part, {_ring.data(), peek_len - first_part});
+    } else {
+        size_t copied = 0;
+        for (auto it = _buffer.begin(); copied < peek_len; ++it) {
+            const size_t piece_len = min(it->size(), peek_len - copied);
+            check.add_copy(copy.data() + copied, it->str().substr(0, piece_len));
+            copied += piece_len;
+        }
+    }
+    return Buffer(move(copy));
+}
+
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
     size_t pop_len = min(len, buffer_size());
     if (pop_len <= 0) {
         return;
     }
-    _bytes_read += pop_len;
+    record_pop(pop_len);
+    if (_storage == Storage::Ring) {
+        return;
+    }
     while (pop_len > 0) {
         if (pop_len > _buffer.front().size()) {
             pop_len -= _buffer.front().size();
@@ -70,6 +307,33 @@ std::string ByteStream::read(const size_t len) {
     return read_str;
 }
 
+//! \param[in] fd is the file descriptor to write to, usually non-blocking
+//! \param[in] max is the largest number of bytes to write
+//! \details Only what `fd` accepts is popped. In Storage::Chunked mode at most the first
+//! `MAX_PIECES` Buffers are written at once.
+size_t ByteStream::read_into(FileDescriptor &fd, const size_t max) {
+    size_t read_len = min(max, buffer_size());
+    if (_storage == Storage::Ring) {
+        array<iovec, 2> regions{};
+        const size_t count = ring_regions(_bytes_read, read_len, regions);
+        const size_t written_len = fd.writev(regions.data(), count);
+        pop_output(written_len);
+        return written_len;
+    }
+
+    constexpr size_t MAX_PIECES = 16;
+    array<iovec, MAX_PIECES> pieces{};
+    size_t count = 0;
+    for (auto it = _buffer.begin(); it != _buffer.end() and count < MAX_PIECES and read_len > 0; ++it) {
+        const size_t piece_len = min(read_len, it->size());
+        pieces[count++] = {const_cast<char *>(it->str().data()), piece_len};
+        read_len -= piece_len;
+    }
+    const size_t written_len = fd.writev(pieces.data(), count);
+    pop_output(written_len);
+    return written_len;
+}
+
 void ByteStream::end_input() { _end = true; }
 
 bool ByteStream::input_ended() const { return _end; }
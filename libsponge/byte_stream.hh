@@ -3,15 +3,27 @@
 
 #include "buffer.hh"
 
+#include <array>
+#include <limits>
 #include <queue>
 #include <string>
 
+class FileDescriptor;
+class InternetChecksum;
+
 //! \brief An in-order byte stream.
 
 //! Bytes are written on the "input" side and read from the "output"
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! How the stream holds the bytes that have been written but not yet read
+    enum class Storage {
+        Ring,    //!< One fixed power-of-two ring allocated at construction; writes and pops never allocate
+        Chunked  //!< A queue of reference-counted Buffers, one per write
+    };
+
   private:
     // Your code here -- add private members as necessary.
 
@@ -19,16 +31,39 @@ class ByteStream {
     // all, but if any of your tests are taking longer than a second,
     // that's a sign that you probably want to keep exploring
     // different approaches.
-    std::deque<Buffer> _buffer{};
+    Storage _storage;
+    std::deque<Buffer> _buffer{};  //!< Buffered bytes in Storage::Chunked mode
+    std::string _ring{};           //!< Buffered bytes in Storage::Ring mode (size is a power of two)
+    size_t _ring_mask{0};          //!< `_ring.size() - 1`, maps a stream index to its ring position
     size_t _capacity;
     size_t _bytes_read{0};
     size_t _bytes_written{0};
     bool _end{false};
     bool _error{false};  //!< Flag indicating that the stream suffered an error.
 
+    size_t _low_watermark;   //!< A paused writer becomes writable again once the buffer drains to this size
+    size_t _high_watermark;  //!< The writer is paused once the buffer holds this many bytes
+    bool _writable{true};    //!< Edge-triggered writer readiness (see set_watermarks())
+
+    //! Account for `len` bytes written, and update the readiness state
+    void record_write(const size_t len);
+
+    //! Account for `len` bytes popped, and update the readiness state
+    void record_pop(const size_t len);
+
+    //! Copy `len` bytes starting at `data` into the free part of the ring
+    void ring_write(const char *data, const size_t len);
+
+    //! Copy `len` buffered bytes, starting at the output side of the ring, to `out`
+    void ring_peek(char *out, const size_t len) const;
+
+    //! Describe the `len` ring bytes starting at stream index `index` as at most two regions
+    //! \returns the number of regions used
+    size_t ring_regions(const size_t index, const size_t len, std::array<iovec, 2> &regions);
+
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const Storage storage = Storage::Ring);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -38,6 +73,26 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write `len` bytes starting at `data` into the stream, as many as will fit
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const char *data, const size_t len);
+
+    //! Write a string of bytes into the stream, adopting its storage if all of it fits
+    //! \returns the number of bytes accepted into the stream
+    //! \note Only Storage::Chunked adopts the string. Storage::Ring copies it into the ring, and
+    //! both modes copy the accepted prefix of a string that doesn't fit.
+    size_t write(std::string &&data);
+
+    //! Write a Buffer into the stream, sharing its storage instead of copying it
+    //! \returns the number of bytes accepted into the stream
+    //! \note Only Storage::Chunked shares the storage (trimmed to the accepted length);
+    //! Storage::Ring copies the bytes into the ring.
+    size_t write(Buffer data);
+
+    //! Read up to `max` bytes from `fd` directly into the stream, as many as will fit
+    //! \returns the number of bytes accepted into the stream
+    size_t write_from(FileDescriptor &fd, const size_t max = std::numeric_limits<size_t>::max());
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -46,6 +101,10 @@ class ByteStream {
 
     //! Indicate that the stream suffered an error.
     void set_error() { _error = true; }
+
+    //! \returns `true` if the writer should write now: the stream has room and has not been paused
+    //! by the high watermark since it last drained to the low watermark
+    bool writable() const;
     //!@}
 
     //! \name "Output" interface for the reader
@@ -55,6 +114,18 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns views of the buffered bytes, valid until the next write or pop
+    BufferViewList peek_views(const size_t len) const;
+
+    //! Peek at next "len" bytes of the stream as reference-counted Buffers
+    //! \returns the buffered pieces (shared, not copied, in Storage::Chunked mode)
+    BufferList peek_buffers(const size_t len) const;
+
+    //! Peek at next "len" bytes of the stream as one Buffer, adding them to `check` on the way
+    //! \returns the bytes, copied and summed in a single pass (or shared, if they are one Storage::Chunked piece)
+    Buffer peek_summed(const size_t len, InternetChecksum &check) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -62,6 +133,10 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Write up to `max` bytes of the stream directly to `fd` (without blocking), and pop what was written
+    //! \returns the number of bytes popped
+    size_t read_into(FileDescriptor &fd, const size_t max = std::numeric_limits<size_t>::max());
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -78,6 +153,20 @@ class ByteStream {
     bool eof() const;
     //!@}
 
+    //! \name Backpressure
+    //!@{
+
+    //! Pause the writer once `high` bytes are buffered, and resume it only after the reader drains
+    //! the buffer to `low` bytes, so that wakeups on both sides come in batches
+    void set_watermarks(const size_t low, const size_t high);
+
+    //! \returns the buffer size at which a paused writer resumes
+    size_t low_watermark() const { return _low_watermark; }
+
+    //! \returns the buffer size at which the writer is paused
+    size_t high_watermark() const { return _high_watermark; }
+    //!@}
+
     //! \name General accounting
     //!@{
 
@@ -86,7 +175,24 @@ class ByteStream {
 
     //! Total number of bytes popped
     size_t bytes_read() const;
+
+    //! How the stream stores its buffered bytes
+    Storage storage() const { return _storage; }
     //!@}
 };
 
+//! \class ByteStream
+//! By default (Storage::Ring) the buffered bytes live in a single ring whose size is `capacity`
+//! rounded up to a power of two. The ring is allocated once by the constructor, so
+//! steady-state writes and pops never touch the heap; stream indices map to ring positions
+//! with a mask. Storage::Chunked keeps the original queue of per-write Buffers.
+//!
+//! write_from() and read_into() move bytes between the stream and a FileDescriptor with a
+//! single [readv(2)](\ref man2::readv) or [writev(2)](\ref man2::writev) on the ring's free
+//! or buffered regions, so an EventLoop copy loop never builds an intermediate string.
+//!
+//! Both watermarks start at the capacity, so by default writable() is simply "not full".
+//! Lowering the low watermark adds hysteresis: an EventLoop rule whose interest is writable()
+//! wakes once per drained batch instead of once for every few bytes the reader frees.
+
 #endif  // SPONGE_LIBSPONGE_BYTE_STREAM_HH
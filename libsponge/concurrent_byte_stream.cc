@@ -0,0 +1,109 @@
+#include "concurrent_byte_stream.hh"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+//! \returns the smallest power of two that is at least `capacity` (and at least 1)
+static size_t ring_size_for(const size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    return size;
+}
+
+ConcurrentByteStream::ConcurrentByteStream(const size_t capacity)
+    : _ring(ring_size_for(capacity), 0), _ring_mask(_ring.size() - 1), _capacity(capacity) {}
+
+//! \details Called only by the writer thread.
+size_t ConcurrentByteStream::write(const string &data) {
+    const size_t written = _bytes_written.load(memory_order_relaxed);
+    const size_t written_len = min(remaining_capacity(), data.size());
+    if (written_len == 0) {
+        return 0;
+    }
+
+    const size_t tail = written & _ring_mask;
+    const size_t first_part = min(written_len, _ring.size() - tail);
+    memcpy(_ring.data() + tail, data.data(), first_part);
+    memcpy(_ring.data(), data.data() + first_part, written_len - first_part);
+
+    // wake the reader only if the stream was empty: if the reader had popped every byte written before these,
+    // it may have seen an empty stream and gone to wait (the store and load pair with those in pop_output())
+    _bytes_written.store(written + written_len, memory_order_seq_cst);
+    if (_bytes_read.load(memory_order_seq_cst) == written) {
+        _readable.notify();
+    }
+    return written_len;
+}
+
+//! \details Called only by the writer thread; the reader can only make this grow.
+size_t ConcurrentByteStream::remaining_capacity() const {
+    return _capacity - (_bytes_written.load(memory_order_relaxed) - _bytes_read.load(memory_order_seq_cst));
+}
+
+void ConcurrentByteStream::end_input() {
+    _end.store(true, memory_order_release);
+    _readable.notify();
+}
+
+void ConcurrentByteStream::set_error() {
+    _error.store(true, memory_order_release);
+    _readable.notify();
+    _writable.notify();
+}
+
+//! \param[in] len bytes will be copied from the output side of the buffer
+//! \details Called only by the reader thread.
+string ConcurrentByteStream::peek_output(const size_t len) const {
+    const size_t peek_len = min(len, buffer_size());
+    const size_t head = _bytes_read.load(memory_order_relaxed) & _ring_mask;
+    const size_t first_part = min(peek_len, _ring.size() - head);
+
+    string peek_str(peek_len, 0);
+    memcpy(peek_str.data(), _ring.data() + head, first_part);
+    memcpy(peek_str.data() + first_part, _ring.data(), peek_len - first_part);
+    return peek_str;
+}
+
+//! \param[in] len bytes will be removed from the output side of the buffer
+//! \details Called only by the reader thread.
+void ConcurrentByteStream::pop_output(const size_t len) {
+    const size_t pop_len = min(len, buffer_size());
+    if (pop_len == 0) {
+        return;
+    }
+    // wake the writer only if the stream was full, so that the writer may have gone to wait for room
+    const size_t read = _bytes_read.load(memory_order_relaxed);
+    _bytes_read.store(read + pop_len, memory_order_seq_cst);
+    if (_bytes_written.load(memory_order_seq_cst) - read == _capacity) {
+        _writable.notify();
+    }
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \returns a string
+string ConcurrentByteStream::read(const size_t len) {
+    string read_str = peek_output(len);
+    pop_output(read_str.size());
+    return read_str;
+}
+
+bool ConcurrentByteStream::input_ended() const { return _end.load(memory_order_acquire); }
+
+//! \details Called only by the reader thread; the writer can only make this grow.
+size_t ConcurrentByteStream::buffer_size() const {
+    return _bytes_written.load(memory_order_seq_cst) - _bytes_read.load(memory_order_relaxed);
+}
+
+bool ConcurrentByteStream::buffer_empty() const { return buffer_size() == 0; }
+
+//! \details `_end` is loaded first: it is stored after the last write, so once it reads `true`
+//! the buffer size seen afterwards includes every byte that will ever be written.
+bool ConcurrentByteStream::eof() const { return input_ended() and buffer_empty(); }
+
+size_t ConcurrentByteStream::bytes_written() const { return _bytes_written.load(memory_order_acquire); }
+
+size_t ConcurrentByteStream::bytes_read() const { return _bytes_read.load(memory_order_acquire); }
@@ -0,0 +1,113 @@
+#ifndef SPONGE_LIBSPONGE_CONCURRENT_BYTE_STREAM_HH
+#define SPONGE_LIBSPONGE_CONCURRENT_BYTE_STREAM_HH
+
+#include "eventfd.hh"
+
+#include <atomic>
+#include <string>
+
+//! \brief An in-order byte stream shared by one writer thread and one reader thread.
+
+//! Same read/write/eof/error semantics as ByteStream, but the "input" interface
+//! may be used by one thread while the "output" interface is used by another,
+//! without locks. Each side can poll an EventFD to learn when the other side has
+//! made progress.
+class ConcurrentByteStream {
+  private:
+    std::string _ring;  //!< Buffered bytes (size is a power of two)
+    size_t _ring_mask;  //!< `_ring.size() - 1`, maps a stream index to its ring position
+    size_t _capacity;
+
+    //! Only the writer stores to this; the release store publishes the bytes written before it
+    alignas(64) std::atomic<size_t> _bytes_written{0};
+    //! Only the reader stores to this; the release store hands the popped space back to the writer
+    alignas(64) std::atomic<size_t> _bytes_read{0};
+
+    std::atomic<bool> _end{false};
+    std::atomic<bool> _error{false};  //!< Flag indicating that the stream suffered an error.
+
+    EventFD _readable{};  //!< Notified when bytes land in an empty stream, and on end_input() or set_error()
+    EventFD _writable{};  //!< Notified when bytes are popped from a full stream
+
+  public:
+    //! Construct a stream with room for `capacity` bytes.
+    ConcurrentByteStream(const size_t capacity);
+
+    //! \name "Input" interface for the writer thread
+    //!@{
+
+    //! Write a string of bytes into the stream. Write as many
+    //! as will fit, and return how many were written.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const std::string &data);
+
+    //! \returns the number of additional bytes that the stream has space for
+    size_t remaining_capacity() const;
+
+    //! Signal that the byte stream has reached its ending
+    void end_input();
+
+    //! Becomes readable when the reader has made room; call EventFD::clear() before writing
+    EventFD &writable_event() { return _writable; }
+    //!@}
+
+    //! Indicate that the stream suffered an error (either thread may call this).
+    void set_error();
+
+    //! \name "Output" interface for the reader thread
+    //!@{
+
+    //! Peek at next "len" bytes of the stream
+    //! \returns a string
+    std::string peek_output(const size_t len) const;
+
+    //! Remove bytes from the buffer
+    void pop_output(const size_t len);
+
+    //! Read (i.e., copy and then pop) the next "len" bytes of the stream
+    //! \returns a string
+    std::string read(const size_t len);
+
+    //! \returns `true` if the stream input has ended
+    bool input_ended() const;
+
+    //! \returns `true` if the stream has suffered an error
+    bool error() const { return _error.load(std::memory_order_acquire); }
+
+    //! \returns the maximum amount that can currently be read from the stream
+    size_t buffer_size() const;
+
+    //! \returns `true` if the buffer is empty
+    bool buffer_empty() const;
+
+    //! \returns `true` if the output has reached the ending
+    bool eof() const;
+
+    //! Becomes readable when there is something new to read; call EventFD::clear() before reading
+    EventFD &readable_event() { return _readable; }
+    //!@}
+
+    //! \name General accounting
+    //!@{
+
+    //! Total number of bytes written
+    size_t bytes_written() const;
+
+    //! Total number of bytes popped
+    size_t bytes_read() const;
+    //!@}
+};
+
+//! \class ConcurrentByteStream
+//! The bytes live in a single ring, allocated by the constructor, whose size is `capacity`
+//! rounded up to a power of two. The writer and the reader each own one of the two running
+//! counters, so neither side ever blocks the other.
+//!
+//! To drive the reader from an EventLoop, add a Direction::In rule on readable_event() whose
+//! callback first calls `readable_event().clear()` and then reads until the stream is empty;
+//! the writer can do the same with writable_event(), writing until the stream is full. The
+//! events are notified only on those transitions (a write into an empty stream, a pop from a
+//! full one), so there is one eventfd write per wakeup rather than per operation; clearing
+//! before draining means a write that lands after the drain always leaves the event readable again.
+
+#endif  // SPONGE_LIBSPONGE_CONCURRENT_BYTE_STREAM_HH
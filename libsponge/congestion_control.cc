@@ -0,0 +1,172 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+using namespace std;
+
+//! The initial window of RFC 6928: ten segments, or 14600 bytes if that is less (but at least two segments)
+static size_t initial_window(const size_t mss) { return min(10 * mss, max(2 * mss, size_t{14600})); }
+
+//! \brief [RFC 5681](https://tools.ietf.org/html/rfc5681) congestion control, counting the window in bytes
+class Reno : public CongestionControl {
+  private:
+    size_t _cwnd;
+    size_t _ssthresh{numeric_limits<size_t>::max()};
+    size_t _bytes_acked{0};  //!< Bytes acked in congestion avoidance since the window last grew
+    bool _new_reno;
+
+  public:
+    Reno(const size_t mss, const bool new_reno)
+        : CongestionControl(mss), _cwnd(initial_window(mss)), _new_reno(new_reno) {}
+
+    string name() const override { return _new_reno ? "NewReno" : "Reno"; }
+    size_t window() const override { return _cwnd; }
+    size_t slow_start_threshold() const override { return _ssthresh; }
+
+    //! \details Slow start grows the window by up to one segment per ack, so it doubles every round trip;
+    //! congestion avoidance grows it by one segment once a whole window has been acked.
+    void on_ack(const size_t acked_bytes, const uint64_t /* now_ms */, const uint64_t /* srtt_ms */) override {
+        if (_cwnd < _ssthresh) {
+            _cwnd += min(acked_bytes, _mss);
+            return;
+        }
+        _bytes_acked += acked_bytes;
+        if (_bytes_acked >= _cwnd) {
+            _bytes_acked -= _cwnd;
+            _cwnd += _mss;
+        }
+    }
+
+    void on_timeout(const size_t bytes_in_flight) override {
+        _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+        _cwnd = _mss;
+        _bytes_acked = 0;
+    }
+
+    void on_fast_retransmit(const size_t bytes_in_flight) override {
+        _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+        _cwnd = _ssthresh + 3 * _mss;
+        _bytes_acked = 0;
+    }
+
+    void on_duplicate_ack() override { _cwnd += _mss; }
+
+    //! \details This is the one difference between Reno and NewReno: Reno leaves recovery at the first new ack.
+    bool recovers_from_partial_acks() const override { return _new_reno; }
+
+    //! \details Deflates the window by the data acked, then adds back a segment if a whole one left the network.
+    void on_partial_ack(const size_t acked_bytes) override {
+        _cwnd -= min(acked_bytes, _cwnd - _mss);
+        if (acked_bytes >= _mss) {
+            _cwnd += _mss;
+        }
+    }
+
+    void on_recovery_end() override { _cwnd = _ssthresh; }
+};
+
+//! \brief [RFC 8312](https://tools.ietf.org/html/rfc8312) congestion control, counting the window in segments
+class Cubic : public CongestionControl {
+  private:
+    static constexpr double C = 0.4;     //!< Scales the cubic growth function
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+
+    double _cwnd;
+    double _ssthresh{numeric_limits<double>::infinity()};
+    double _w_max{0};                        //!< Window just before the last reduction
+    double _k{0};                            //!< Seconds the cubic function takes to grow back to `_origin`
+    double _origin{0};                       //!< Window the cubic function plateaus at
+    double _w_est{0};                        //!< What Reno's window would be, so CUBIC is never slower than Reno
+    std::optional<uint64_t> _epoch_start{};  //!< When the current congestion avoidance period began
+
+    //! Multiplicative decrease, remembering the window we backed off from
+    void reduce() {
+        // fast convergence: release bandwidth sooner when the window stopped short of the last plateau
+        _w_max = _cwnd < _w_max ? _cwnd * (1 + BETA) / 2 : _cwnd;
+        _ssthresh = max(_cwnd * BETA, 2.0);
+        _epoch_start.reset();
+    }
+
+  public:
+    explicit Cubic(const size_t mss) : CongestionControl(mss), _cwnd(double(initial_window(mss)) / mss) {}
+
+    string name() const override { return "CUBIC"; }
+    //! \details Whole segments only, so a growing window doesn't release slivers of a segment to the sender
+    size_t window() const override { return static_cast<size_t>(_cwnd) * _mss; }
+    size_t slow_start_threshold() const override {
+        return isinf(_ssthresh) ? numeric_limits<size_t>::max() : static_cast<size_t>(_ssthresh * _mss);
+    }
+
+    //! \details In congestion avoidance the window follows W(t) = C * (t - K)^3 + W_max, evaluated one
+    //! round trip ahead, or Reno's estimated window if that is larger.
+    void on_ack(const size_t acked_bytes, const uint64_t now_ms, const uint64_t srtt_ms) override {
+        const double segments = double(acked_bytes) / _mss;
+        if (_cwnd < _ssthresh) {
+            _cwnd += min(segments, 1.0);
+            return;
+        }
+
+        if (not _epoch_start.has_value()) {
+            _epoch_start = now_ms;
+            if (_cwnd < _w_max) {
+                _k = cbrt((_w_max - _cwnd) / C);
+                _origin = _w_max;
+            } else {
+                _k = 0;
+                _origin = _cwnd;
+            }
+            _w_est = _cwnd;
+        }
+
+        const double t = double(now_ms - _epoch_start.value() + srtt_ms) / 1000;
+        const double target = clamp(_origin + C * pow(t - _k, 3), _cwnd, 1.5 * _cwnd);
+        _w_est += 3 * (1 - BETA) / (1 + BETA) * segments / _cwnd;
+        if (target < _w_est) {
+            _cwnd = _w_est;
+        } else {
+            _cwnd += (target - _cwnd) / _cwnd * segments;
+        }
+    }
+
+    void on_timeout(const size_t /* bytes_in_flight */) override {
+        reduce();
+        _cwnd = 1;
+    }
+
+    //! \details Recovery follows NewReno, in segments; only the reduction is CUBIC's own.
+    void on_fast_retransmit(const size_t /* bytes_in_flight */) override {
+        reduce();
+        _cwnd = _ssthresh + 3;
+    }
+
+    void on_duplicate_ack() override { _cwnd += 1; }
+
+    bool recovers_from_partial_acks() const override { return true; }
+
+    void on_partial_ack(const size_t acked_bytes) override {
+        const double segments = double(acked_bytes) / _mss;
+        _cwnd = max(_cwnd - segments, 1.0);
+        if (segments >= 1) {
+            _cwnd += 1;
+        }
+    }
+
+    void on_recovery_end() override { _cwnd = _ssthresh; }
+};
+
+unique_ptr<CongestionControl> CongestionControl::make(const Algorithm algorithm, const size_t mss) {
+    switch (algorithm) {
+        case Algorithm::None:
+            return nullptr;
+        case Algorithm::Reno:
+            return make_unique<Reno>(mss, false);
+        case Algorithm::NewReno:
+            return make_unique<Reno>(mss, true);
+        case Algorithm::Cubic:
+            return make_unique<Cubic>(mss);
+    }
+    return nullptr;
+}
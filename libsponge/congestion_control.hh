@@ -0,0 +1,76 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+//! \brief A congestion window, which a congestion control algorithm adjusts as TCPSender reports acks and losses
+//! \details TCPSender never has more than window() bytes in flight, on top of the limit set by the peer's
+//! receive window. Implementations are selected through TCPConfig::congestion_control.
+class CongestionControl {
+  public:
+    //! The algorithms TCPConfig can select
+    enum class Algorithm {
+        None,     //!< No congestion window: send whatever the peer's window allows
+        Reno,     //!< Slow start, then additive increase and multiplicative decrease (RFC 5681)
+        NewReno,  //!< Reno, with fast recovery that lasts across partial acks (RFC 6582)
+        Cubic     //!< Window growth as a cubic function of the time since the last loss (RFC 8312)
+    };
+
+    //! \brief Construct the algorithm, with its initial window sized for `mss`-byte segments
+    //! \returns nullptr for Algorithm::None
+    static std::unique_ptr<CongestionControl> make(const Algorithm algorithm, const size_t mss);
+
+    virtual ~CongestionControl() = default;
+
+    //! \brief The algorithm's name, for benchmarks and debugging output
+    virtual std::string name() const = 0;
+
+    //! \brief The congestion window: most bytes (in sequence space) the sender may have in flight
+    virtual size_t window() const = 0;
+
+    //! \brief The slow-start threshold, in bytes (SIZE_MAX until the first loss)
+    virtual size_t slow_start_threshold() const = 0;
+
+    //! \brief New data was acknowledged
+    //! \param[in] acked_bytes sequence space newly acknowledged
+    //! \param[in] now_ms the sender's clock
+    //! \param[in] srtt_ms smoothed round-trip time, or zero before the first measurement
+    virtual void on_ack(const size_t acked_bytes, const uint64_t now_ms, const uint64_t srtt_ms) = 0;
+
+    //! \brief The retransmission timer expired while `bytes_in_flight` were outstanding
+    virtual void on_timeout(const size_t bytes_in_flight) = 0;
+
+    //! \name Fast recovery ([RFC 5681](https://tools.ietf.org/html/rfc5681) section 3.2)
+    //!@{
+
+    //! \brief Duplicate acks triggered a fast retransmit while `bytes_in_flight` were outstanding
+    //! \details Sets ssthresh as for a loss, and the window to ssthresh plus the three segments that have left.
+    virtual void on_fast_retransmit(const size_t bytes_in_flight) = 0;
+
+    //! \brief Another duplicate ack arrived during recovery: one more segment has left the network
+    virtual void on_duplicate_ack() = 0;
+
+    //! \brief Does a partial ack (one that doesn't cover everything sent before recovery) keep recovery
+    //! going ([RFC 6582](https://tools.ietf.org/html/rfc6582)), or end it?
+    virtual bool recovers_from_partial_acks() const = 0;
+
+    //! \brief A partial ack of `acked_bytes` arrived, and recovery continues
+    virtual void on_partial_ack(const size_t acked_bytes) = 0;
+
+    //! \brief Recovery is over: deflate the window back to ssthresh
+    virtual void on_recovery_end() = 0;
+    //!@}
+
+    //! \brief Count the window in `mss`-byte segments from now on (e.g. once the MSS is negotiated)
+    void set_mss(const size_t mss) { _mss = mss; }
+
+  protected:
+    explicit CongestionControl(const size_t mss) : _mss(mss) {}
+
+    size_t _mss;  //!< Segment size, the unit of window growth
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
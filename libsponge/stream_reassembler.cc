@@ -1,6 +1,7 @@
 #include "stream_reassembler.hh"
 
-#include "iostream"
+#include <cstring>
+
 // Dummy implementation of a stream reassembler.
 
 // For Lab 1, please replace with a real implementation that passes the
@@ -13,107 +14,305 @@
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity)
-    : _str_to_assemble(), _output(capacity), _capacity(capacity) {}
+//! \returns the smallest power of two that is at least `capacity` and at least one bitmap word
+static size_t window_size_for(const size_t capacity) {
+    size_t size = 64;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    return size;
+}
+
+//! \param[in] capacity the maximum number of bytes held, assembled or not
+//! \param[in] engine how out-of-order bytes are held; Engine::Bitmap allocates its ring up front
+//! \param[in] storage how the output holds reassembled bytes; only Storage::Chunked keeps in-order Buffers
+//! without copying them
+StreamReassembler::StreamReassembler(const size_t capacity, const Engine engine, const ByteStream::Storage storage)
+    : _engine(engine), _output(capacity, storage), _capacity(capacity) {
+    if (_engine == Engine::Bitmap) {
+        _window.resize(window_size_for(_capacity));
+        _present.resize(_window.size() / 64);
+        _window_mask = _window.size() - 1;
+    }
+}
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    size_t cur_win_max_idx = _first_unassembled_index + _capacity - _output.buffer_size();
-    if (index >= cur_win_max_idx)
-        return;
+    push_bytes(data, index, eof, nullptr);
+}
 
-    if (eof) {
-        _eof = true;
-    }
-    // cut the chars which are out of window or have been assembled
-    size_t data_start_idx = max(index, _first_unassembled_index);
-    size_t data_end_idx = min(cur_win_max_idx, index + data.size());
-    if (data_end_idx >= data_start_idx) {
-        pair<size_t, size_t> cur_data_start_end_index = make_pair(data_start_idx, data_end_idx);
-        string cur_data = data.substr(data_start_idx - index, data_end_idx - data_start_idx + 1);
-        // insert current data to str_to_assemble map
-        recv_bytes_t cur_recv_bytes = {cur_data_start_end_index, cur_data};
-        while (!this->empty()) {
-            auto iter = _str_to_assemble.lower_bound(cur_data_start_end_index);
-            bool cur_data_could_merge_right =
-                (iter != _str_to_assemble.end()) && (cur_recv_bytes.first.second >= iter->first.first);
-            if (cur_data_could_merge_right) {
-                cur_recv_bytes = merge_two_unassembled_strs(cur_recv_bytes, *iter);
-                _unassembled_bytes -= iter->second.size();
-                _str_to_assemble.erase(iter);
-                iter = _str_to_assemble.lower_bound(cur_data_start_end_index);
-            }
+//! \details An in-order substring is handed to the output as it is, sharing the Buffer's storage. An
+//! out-of-order one is copied: it may wait a long time for the gap before it to fill, and a slice of
+//! a received datagram would keep the whole datagram's allocation alive until then.
+void StreamReassembler::push_substring(Buffer data, const uint64_t index, const bool eof) {
+    const string_view bytes = data.str();
+    push_bytes(bytes, index, eof, &data);
+}
 
-            bool cur_data_could_merge_left =
-                (iter != _str_to_assemble.begin()) && ((--iter)->first.second >= cur_recv_bytes.first.first);
-            if (cur_data_could_merge_left) {
-                cur_recv_bytes = merge_two_unassembled_strs(*iter, cur_recv_bytes);
-                _unassembled_bytes -= iter->second.size();
-                _str_to_assemble.erase(iter);
-            }
-            if (!cur_data_could_merge_right && !cur_data_could_merge_left) {
-                break;
-            }
+//! \param[in] data the bytes of the substring
+//! \param[in] owner if not null, a Buffer holding exactly `data`, which may be trimmed and written to the output
+void StreamReassembler::push_bytes(const string_view data, const uint64_t index, const bool eof, Buffer *owner) {
+    if (eof and not _eof_index.has_value()) {
+        _eof_index = index + data.size();
+    }
+
+    // cut the bytes that have already been assembled or that are beyond the window
+    const uint64_t window_end = _output.bytes_read() + _capacity;
+    const uint64_t start = max<uint64_t>(index, _first_unassembled_index);
+    const uint64_t end = min<uint64_t>(index + data.size(), window_end);
+    if (start < end and start > _first_unassembled_index) {
+        if (_engine == Engine::Bitmap) {
+            bitmap_insert(data.data() + (start - index), start, end - start);
+        } else {
+            insert_pending(data.substr(start - index, end - start), start);
+            enforce_budget();
         }
-        // insert the unassembled str to map
-        _str_to_assemble.insert(cur_recv_bytes);
-        _unassembled_bytes += cur_recv_bytes.second.size();
-    }
-
-    // if the first chunk start index is smaller than _first_unassembled_index
-    // write the first chunk to output bytestream
-    auto iter = _str_to_assemble.begin();
-    if (!_str_to_assemble.empty() && (iter->first.first <= _first_unassembled_index)) {
-        auto temp_map_head = *iter;
-        _str_to_assemble.erase(iter);
-        size_t written_len = _output.write(temp_map_head.second);
-        _unassembled_bytes -= written_len;
-        if (written_len == temp_map_head.second.size()) {
-            // The first chunk was all written to the output stream
-            _first_unassembled_index = temp_map_head.first.first + temp_map_head.second.size();
+    } else if (start < end) {
+        // in order: write straight to the output
+        const uint64_t assembled_from = _first_unassembled_index;
+        if (owner) {
+            owner->remove_prefix(start - index);
+            owner->remove_suffix(owner->size() - (end - start));
+            _first_unassembled_index += _output.write(move(*owner));
         } else {
-            // Part of first chunk was written to the output stream
-            size_t new_data_start_index = temp_map_head.first.first + written_len;
-            _str_to_assemble.insert(
-                {{new_data_start_index, temp_map_head.first.second}, temp_map_head.second.substr(written_len)});
-            _first_unassembled_index = new_data_start_index;
+            _first_unassembled_index += _output.write(data.data() + (start - index), end - start);
+        }
+        if (_engine == Engine::Bitmap) {
+            // forget any pending bytes that were just written
+            _unassembled_bytes -= bitmap_mark(assembled_from, _first_unassembled_index - assembled_from, false);
+            bitmap_assemble();
+        } else {
+            assemble_pending();
         }
     }
-    if (empty() && _eof) {
+
+    if (_eof_index.has_value() and _first_unassembled_index >= _eof_index.value()) {
         _output.end_input();
     }
 }
 
-size_t StreamReassembler::unassembled_bytes() const { return _unassembled_bytes; }
+//! \details Bytes that are already stored win: `data` is split around them, and each remaining
+//! piece is copied into a string of its own size, so that memory_footprint() counts its storage exactly.
+void StreamReassembler::insert_pending(string_view data, uint64_t index) {
+    auto next = _pending.upper_bound(index);
+    if (next != _pending.begin()) {
+        const auto prev = std::prev(next);
+        const uint64_t prev_end = prev->first + prev->second.size();
+        if (prev_end >= index + data.size()) {
+            return;
+        }
+        if (prev_end > index) {
+            data.remove_prefix(prev_end - index);
+            index = prev_end;
+        }
+    }
 
-bool StreamReassembler::empty() const { return _unassembled_bytes == 0; }
+    while (data.size() > 0) {
+        const uint64_t end = index + data.size();
+        if (next == _pending.end() or next->first >= end) {
+            _unassembled_bytes += data.size();
+            _pending.emplace_hint(next, index, Buffer(string(data)));
+            return;
+        }
+
+        // store the gap before `next`, then skip over the bytes `next` already holds
+        if (next->first > index) {
+            const string_view gap = data.substr(0, next->first - index);
+            _unassembled_bytes += gap.size();
+            _pending.emplace_hint(next, index, Buffer(string(gap)));
+        }
+        const uint64_t next_end = next->first + next->second.size();
+        if (next_end >= end) {
+            return;
+        }
+        data.remove_prefix(next_end - index);
+        index = next_end;
+        ++next;
+    }
+}
+
+void StreamReassembler::assemble_pending() {
+    while (not _pending.empty()) {
+        auto first = _pending.begin();
+        if (first->first > _first_unassembled_index) {
+            break;
+        }
+
+        Buffer slice = move(first->second);
+        const uint64_t slice_index = first->first;
+        _unassembled_bytes -= slice.size();
+        _pending.erase(first);
+
+        const uint64_t already_assembled = _first_unassembled_index - slice_index;
+        if (already_assembled >= slice.size()) {
+            continue;
+        }
+        slice.remove_prefix(already_assembled);
+        const size_t written = _output.write(slice);
+        _first_unassembled_index += written;
+        if (written < slice.size()) {
+            // the output is full; keep (a copy of) the rest for later
+            _unassembled_bytes += slice.size() - written;
+            _pending.emplace(_first_unassembled_index, Buffer(string(slice.str().substr(written))));
+            break;
+        }
+    }
+}
+
+void StreamReassembler::set_memory_budget(const size_t budget, const Eviction eviction) {
+    _memory_budget = budget;
+    _eviction = eviction;
+    enforce_budget();
+}
 
-//! \details This function merge two recv_bytes_type pairs, the start index of a is always smaller than b.
-StreamReassembler::recv_bytes_t StreamReassembler::merge_two_unassembled_strs(
-    const StreamReassembler::recv_bytes_t &a,
-    const StreamReassembler::recv_bytes_t &b) const {
-    recv_bytes_t res;
-    res.first.first = a.first.first;
-    // choose the bigger one for the end index of merged string.
-    if (a.first.second > b.first.second) {
-        res.first.second = a.first.second;
-        res.second = a.second;
-    } else {
-        res.first.second = b.first.second;
-        res.second = a.second.substr(0, b.first.first - a.first.first) + b.second;
+size_t StreamReassembler::memory_footprint() const {
+    if (_engine == Engine::Bitmap) {
+        return _window.size() + _present.size() * sizeof(uint64_t);
     }
-    return res;
+    return _pending.size() * PENDING_ENTRY_OVERHEAD + _unassembled_bytes;
 }
 
-void StreamReassembler::debug_strs_to_assemble(const map<pair<size_t, size_t>, string> &_str_to_assemble) {
-    cerr << "Start Index \t End Index \n";
-    for (const auto &iter : _str_to_assemble) {
-        cerr << "\t" << iter.first.first << "\t\t" << iter.first.second << "\t" << iter.second << endl;
+void StreamReassembler::enforce_budget() {
+    if (_engine == Engine::Bitmap or memory_footprint() <= _memory_budget) {
+        return;
+    }
+    if (_eviction == Eviction::Coalesce) {
+        coalesce_pending();
+    }
+
+    while (not _pending.empty() and memory_footprint() > _memory_budget) {
+        const auto last = std::prev(_pending.end());
+        const size_t excess = memory_footprint() - _memory_budget;
+        if (excess < last->second.size()) {
+            // trimming the end of the last slice is enough (copied, so the trimmed bytes are freed)
+            last->second = Buffer(string(last->second.str().substr(0, last->second.size() - excess)));
+            _unassembled_bytes -= excess;
+        } else {
+            _unassembled_bytes -= last->second.size();
+            _pending.erase(last);
+        }
+    }
+}
+
+//! \details Each run then costs PENDING_ENTRY_OVERHEAD once, rather than once per slice.
+void StreamReassembler::coalesce_pending() {
+    auto run_begin = _pending.begin();
+    while (run_begin != _pending.end()) {
+        auto run_end = std::next(run_begin);
+        uint64_t end = run_begin->first + run_begin->second.size();
+        while (run_end != _pending.end() and run_end->first == end) {
+            end += run_end->second.size();
+            ++run_end;
+        }
+        if (std::next(run_begin) != run_end) {
+            string merged;
+            merged.reserve(end - run_begin->first);
+            for (auto it = run_begin; it != run_end; ++it) {
+                merged.append(it->second.str());
+            }
+            run_begin->second = Buffer(move(merged));
+            _pending.erase(std::next(run_begin), run_end);
+        }
+        run_begin = run_end;
+    }
+}
+
+void StreamReassembler::bitmap_insert(const char *data, const uint64_t index, const size_t len) {
+    const size_t pos = index & _window_mask;
+    const size_t first_part = min(len, _window.size() - pos);
+    memcpy(_window.data() + pos, data, first_part);
+    memcpy(_window.data(), data + first_part, len - first_part);
+    _unassembled_bytes += bitmap_mark(index, len, true);
+}
+
+//! \details Works a word at a time; the ring size is a multiple of 64, so no word straddles the wrap point.
+size_t StreamReassembler::bitmap_mark(const uint64_t index, const size_t len, const bool present) {
+    size_t changed = 0;
+    size_t pos = index & _window_mask;
+    size_t remaining = len;
+    while (remaining > 0) {
+        const size_t bit = pos % 64;
+        const size_t n = min(remaining, 64 - bit);
+        const uint64_t mask = (n == 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1) << bit;
+        uint64_t &word = _present[pos / 64];
+        const uint64_t updated = present ? (word | mask) : (word & ~mask);
+        changed += __builtin_popcountll(word ^ updated);
+        word = updated;
+        remaining -= n;
+        pos = (pos + n) & _window_mask;
     }
+    return changed;
 }
 
-void StreamReassembler::debug_recv_bytes(const StreamReassembler::recv_bytes_t &a) {
-    printf("Start Index: %ld \t End Index: %ld \t String %s \n", a.first.first, a.first.second, a.second.c_str());
+//! \details Scans a 64-bit word at a time, using count-trailing-zeros to find where the run ends.
+size_t StreamReassembler::bitmap_run(const uint64_t index, const bool present) const {
+    size_t run = 0;
+    size_t pos = index & _window_mask;
+    while (run < _window.size()) {
+        const size_t bit = pos % 64;
+        const uint64_t word = _present[pos / 64] >> bit;
+        const uint64_t ends = present ? ~word : word;  // bits past the end of the word are checked below
+        const size_t available = 64 - bit;
+        if (ends != 0 and static_cast<size_t>(__builtin_ctzll(ends)) < available) {
+            return run + __builtin_ctzll(ends);
+        }
+        run += available;
+        pos = (pos + available) & _window_mask;
+    }
+    return run;
 }
+
+void StreamReassembler::bitmap_assemble() {
+    const size_t run = bitmap_run(_first_unassembled_index);
+    if (run == 0) {
+        return;
+    }
+
+    const size_t pos = _first_unassembled_index & _window_mask;
+    const size_t first_part = min(run, _window.size() - pos);
+    size_t written = _output.write(_window.data() + pos, first_part);
+    if (written == first_part) {
+        written += _output.write(_window.data(), run - first_part);
+    }
+    bitmap_mark(_first_unassembled_index, written, false);
+    _unassembled_bytes -= written;
+    _first_unassembled_index += written;
+}
+
+size_t StreamReassembler::unassembled_bytes() const { return _unassembled_bytes; }
+
+//! \details Engine::Intervals merges touching slices; Engine::Bitmap alternates between runs of present and
+//! absent bytes across the window.
+vector<pair<uint64_t, uint64_t>> StreamReassembler::pending_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    if (_unassembled_bytes == 0) {
+        return ranges;
+    }
+
+    if (_engine == Engine::Bitmap) {
+        const uint64_t window_end = _output.bytes_read() + _capacity;
+        size_t remaining = _unassembled_bytes;
+        uint64_t index = _first_unassembled_index;
+        while (remaining > 0 and index < window_end) {
+            index += bitmap_run(index, false);
+            const uint64_t end = min<uint64_t>(index + bitmap_run(index), window_end);
+            ranges.emplace_back(index, end);
+            remaining -= min<size_t>(remaining, end - index);
+            index = end;
+        }
+        return ranges;
+    }
+
+    for (const auto &[index, slice] : _pending) {
+        if (not ranges.empty() and ranges.back().second == index) {
+            ranges.back().second += slice.size();
+        } else {
+            ranges.emplace_back(index, index + slice.size());
+        }
+    }
+    return ranges;
+}
+
+bool StreamReassembler::empty() const { return _unassembled_bytes == 0; }
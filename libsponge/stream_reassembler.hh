@@ -1,38 +1,99 @@
 #ifndef SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
+#include "buffer.hh"
 #include "byte_stream.hh"
 
 #include <cstdint>
+#include <limits>
 #include <map>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 using std::map;
 using std::pair;
 using std::string;
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
+  public:
+    //! How the reassembler holds bytes that arrived before a gap in the stream
+    enum class Engine {
+        Intervals,  //!< Non-overlapping Buffer slices in an ordered map, holding copies of the substrings
+        Bitmap      //!< A fixed ring of `capacity` bytes plus a bitmap of which ring positions hold bytes
+    };
+
+    //! What Engine::Intervals does when its memory footprint exceeds the budget
+    enum class Eviction {
+        DropFarthest,  //!< Drop the bytes farthest from the next byte the output needs
+        Coalesce       //!< First merge touching slices into one Buffer each, then drop the farthest bytes
+    };
+
+    //! Bookkeeping cost of each pending slice: its map node, the Buffer in it, and the Buffer's shared block
+    static constexpr size_t PENDING_ENTRY_OVERHEAD =
+        sizeof(pair<const uint64_t, Buffer>) + 4 * sizeof(void *) + BufferPool::BLOCK_SIZE;
+
   private:
     // Your code here -- add private members as necessary.
+    Engine _engine;
+    //! Bytes waiting for a gap before them to be filled, keyed by the stream index of their first byte.
+    //! The slices never overlap, and each owns a string holding exactly its bytes.
+    map<uint64_t, Buffer> _pending{};
     size_t _unassembled_bytes{0};
-    size_t _first_unassembled_index{0};
-    bool _eof{false};
-    // key-> <start_idx, end_idx>, value -> str_to_assembled
-    using recv_bytes_t = pair<pair<size_t, size_t>, std::string>;
-    map<pair<size_t, size_t>, std::string> _str_to_assemble;
+    uint64_t _first_unassembled_index{0};
+    std::optional<uint64_t> _eof_index{};  //!< Stream index just past the last byte, once it is known
+
+    std::string _window{};             //!< Engine::Bitmap ring of pending bytes (size is a power of two)
+    std::vector<uint64_t> _present{};  //!< Engine::Bitmap presence bits, one per ring position
+    size_t _window_mask{0};            //!< `_window.size() - 1`, maps a stream index to its ring position
+
+    size_t _memory_budget{std::numeric_limits<size_t>::max()};  //!< Most memory_footprint() may reach
+    Eviction _eviction{Eviction::DropFarthest};                 //!< How to get back under the budget
 
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
 
-    recv_bytes_t merge_two_unassembled_strs(const recv_bytes_t &a, const recv_bytes_t &b) const;
-    static void debug_strs_to_assemble(const map<pair<size_t, size_t>, std::string> &_str_to_assemble);
-    static void debug_recv_bytes(const recv_bytes_t &a);
+    //! Store copies of the parts of `data` (which starts at stream index `index`) that are not already stored
+    void insert_pending(std::string_view data, uint64_t index);
+
+    //! Write any stored slices that have become contiguous with the output
+    void assemble_pending();
+
+    //! Apply the eviction policy until memory_footprint() is within the budget
+    void enforce_budget();
+
+    //! Replace each run of touching slices with a single slice holding a copy of their bytes
+    void coalesce_pending();
+
+    //! Accept a substring, viewed by `data` and (optionally) owned by `owner`
+    void push_bytes(const std::string_view data, const uint64_t index, const bool eof, Buffer *owner);
+
+    //! \name Engine::Bitmap helpers
+    //!@{
+
+    //! Copy `len` bytes into the ring at stream index `index`, and mark them present
+    void bitmap_insert(const char *data, const uint64_t index, const size_t len);
+
+    //! Set (or clear) the presence bits of `len` bytes starting at stream index `index`
+    //! \returns how many bits actually changed
+    size_t bitmap_mark(const uint64_t index, const size_t len, const bool present);
+
+    //! \returns the number of consecutive bytes starting at stream index `index` that are `present` (or, if
+    //! `present` is false, absent)
+    size_t bitmap_run(const uint64_t index, const bool present = true) const;
+
+    //! Write the bytes that have become contiguous with the output from the ring
+    void bitmap_assemble();
+    //!@}
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    StreamReassembler(const size_t capacity,
+                      const Engine engine = Engine::Intervals,
+                      const ByteStream::Storage storage = ByteStream::Storage::Ring);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -44,6 +105,12 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer, without copying it if it arrives in order
+    //! \param data the substring, whose storage the output may keep
+    //! \param index indicates the index (place in sequence) of the first byte in `data`
+    //! \param eof the last byte of `data` will be the last byte in the entire stream
+    void push_substring(Buffer data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -56,9 +123,44 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The runs of contiguous bytes stored beyond the next gap in the stream
+    //! \returns `[first, last)` stream index pairs, in ascending order (what a receiver reports as SACK blocks)
+    std::vector<pair<uint64_t, uint64_t>> pending_ranges() const;
+
+    //! \brief Bound the memory held for bytes that have not been reassembled
+    //! \details Only Engine::Intervals grows with fragmentation; Engine::Bitmap allocates its
+    //! footprint up front and never evicts. Evicted bytes are simply not stored, as if they had
+    //! fallen outside the window, so the sender's retransmission delivers them again.
+    //! \param budget the most that memory_footprint() may reach
+    //! \param eviction how to get back under the budget
+    void set_memory_budget(const size_t budget, const Eviction eviction = Eviction::DropFarthest);
+
+    //! \brief The memory held for bytes that have not been reassembled, including bookkeeping
+    //! \details For Engine::Intervals, PENDING_ENTRY_OVERHEAD per slice plus the bytes in the
+    //! slices, which is all the storage they hold (each slice owns a string of exactly its size);
+    //! for Engine::Bitmap, the ring and its bitmap.
+    size_t memory_footprint() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
 };
 
+//! \class StreamReassembler
+//! Substrings that arrive in order are written straight to the output, sharing their storage. With
+//! Engine::Intervals, others go into Buffer slices in an interval map. A substring that overlaps
+//! bytes already stored is trimmed by offset first, so only the gaps are kept. Slices that become
+//! contiguous go to the output as Buffers, which a Storage::Chunked output keeps without copying.
+//!
+//! Each gap is copied once, into a string of its own size, rather than kept as a slice sharing the
+//! received storage. That costs a copy of every out-of-order byte, but a few pending bytes never pin a
+//! whole datagram, and memory_footprint() is the memory the slices actually hold, so the budget
+//! really bounds it.
+//!
+//! Engine::Bitmap relies on the window being bounded by the capacity: pending bytes are copied
+//! into a ring allocated once by the constructor, at `index & mask`, and a bitmap records which
+//! positions hold bytes. Insertion is a copy plus a few word-wide bit operations, the next
+//! contiguous run is found a 64-bit word at a time, and memory use does not depend on how
+//! fragmented the arrivals are.
+
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
@@ -1,6 +1,8 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -27,6 +29,7 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         set_rst_state();
         return;
     }
+    options_received(seg.header());
     _receiver.segment_received(seg);
     size_t seg_length = seg.length_in_sequence_space();
     // Passive open a TCP connection, when received the first SYN segment
@@ -46,7 +49,17 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     // Received segment contains the ACK flag
     if (seg.header().ack) {
         // sender will use the newest ackno&win_size, then it will fill the window.
-        _sender.ack_received(seg.header().ackno, seg.header().win);
+        // the window in a SYN segment is never scaled
+        const size_t window = static_cast<size_t>(seg.header().win) << (seg.header().syn ? 0 : _snd_window_shift);
+        // with timestamps, the echoed TSval times the round trip
+        optional<uint32_t> echoed_timestamp{};
+        if (_timestamps_ok and seg.header().options.timestamps.has_value()) {
+            echoed_timestamp = seg.header().options.timestamps.value().echo_reply;
+        }
+        if (_sack_ok and not seg.header().options.sack.empty()) {
+            _sender.sack_received(seg.header().options.sack);
+        }
+        _sender.ack_received(seg.header().ackno, window, echoed_timestamp, seg_length != 0);
         if (seg_length != 0 && _sender.segments_out().empty()) {
             need_send_empty_ack = true;
         }
@@ -74,8 +87,15 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 
 bool TCPConnection::active() const { return _active; }
 
-size_t TCPConnection::write(const string &data) {
-    size_t written_size = _sender.stream_in().write(data);
+size_t TCPConnection::write(const string &data) { return send_written_bytes(_sender.stream_in().write(data)); }
+
+size_t TCPConnection::write(string &&data) { return send_written_bytes(_sender.stream_in().write(move(data))); }
+
+size_t TCPConnection::write(Buffer data) { return send_written_bytes(_sender.stream_in().write(move(data))); }
+
+size_t TCPConnection::write_from(FileDescriptor &fd) { return send_written_bytes(_sender.stream_in().write_from(fd)); }
+
+size_t TCPConnection::send_written_bytes(const size_t written_size) {
     _sender.fill_window();
     send_segments_in_sender_queue();
     return written_size;
@@ -151,9 +171,70 @@ void TCPConnection::send_segments_in_sender_queue() {
         if (_receiver.ackno().has_value()) {
             seg.header().ack = true;
             seg.header().ackno = _receiver.ackno().value();
+            _last_ack_sent = seg.header().ackno;
         }
-        seg.header().win = _receiver.window_size();
+        seg.header().win = _receiver.advertised_window(seg.header().syn);
+        add_options(seg.header());
         _segments_out.push(seg);
         _debugger.print_segment(*this, seg, "Segment sent!");
     }
 }
+
+uint8_t TCPConnection::window_shift_for(const TCPConfig &cfg) {
+    uint8_t shift = 0;
+    while (cfg.window_scaling and shift < TCPOptions::MAX_WINDOW_SCALE and
+           (cfg.recv_capacity >> shift) > numeric_limits<uint16_t>::max()) {
+        shift++;
+    }
+    return shift;
+}
+
+//! \details The peer's SYN settles the MSS, and whether window scaling, timestamps and SACK are used:
+//! each takes effect only if both SYNs offered it (RFC 7323).
+void TCPConnection::options_received(const TCPHeader &header) {
+    const TCPOptions &options = header.options;
+    if (header.syn) {
+        _sender.set_max_payload_size(min<size_t>(_cfg.mss, options.mss.value_or(_cfg.mss)));
+        _window_scaling_ok = _cfg.window_scaling and options.window_scale.has_value();
+        if (_window_scaling_ok) {
+            _snd_window_shift = options.window_scale.value();
+            _receiver.set_window_shift(_rcv_window_shift);
+        }
+        _timestamps_ok = _cfg.timestamps and options.timestamps.has_value();
+        _sack_ok = _cfg.sack and options.sack_permitted;
+    }
+
+    // keep the newest TSval (compared with wraparound, like sequence numbers), but only from a segment at or
+    // before the ackno we last sent: while there is a hole, our acks echo the segment that last advanced the
+    // left edge, so that the peer's RTT samples include the time spent recovering (RFC 7323 section 4.3)
+    if (_timestamps_ok and options.timestamps.has_value()) {
+        const uint32_t value = options.timestamps.value().value;
+        const bool in_order = _last_ack_sent.has_value() and header.seqno - _last_ack_sent.value() <= 0;
+        if (header.syn or (in_order and static_cast<int32_t>(value - _ts_recent) >= 0)) {
+            _ts_recent = value;
+        }
+    }
+}
+
+//! \details Our SYN offers every option the config enables; the SYN-ACK of a passive open only
+//! offers what the peer's SYN did, and later segments carry timestamps and SACK blocks only once both
+//! sides agreed.
+void TCPConnection::add_options(TCPHeader &header) const {
+    const bool peer_syn_received = _receiver.ackno().has_value();
+    TCPOptions &options = header.options;
+    if (header.syn) {
+        options.mss = _cfg.mss;
+        if (_cfg.window_scaling and (not peer_syn_received or _window_scaling_ok)) {
+            options.window_scale = _rcv_window_shift;
+        }
+        options.sack_permitted = _cfg.sack and (not peer_syn_received or _sack_ok);
+    }
+    const bool offer_timestamps = header.syn and not peer_syn_received and _cfg.timestamps;
+    if (offer_timestamps or _timestamps_ok) {
+        options.timestamps = TCPOptions::Timestamps{static_cast<uint32_t>(_sender.clock_ms()), _ts_recent};
+    }
+    if (_sack_ok and not header.syn) {
+        options.sack = _receiver.sack_blocks(options.sack_capacity());
+    }
+    header.fit_options();
+}
@@ -54,7 +54,7 @@ class TCPConnection {
   private:
     TCPConnectionDebugger _debugger{};
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
+    TCPReceiver _receiver{_cfg.recv_capacity, _cfg.recv_storage};
     TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
 
     //! outbound queue of segments that the TCPConnection wants sent
@@ -67,6 +67,8 @@ class TCPConnection {
 
     //! Send all segment in sender's output queue, and set the ACK flag and a proper `ackno`
     void send_segments_in_sender_queue();
+    //! Send whatever the outbound stream now allows after a write, and pass through its return value
+    size_t send_written_bytes(const size_t written_size);
     //! TCP Conn inner state
     //! TCP connection in active state means that it is other than CLOSED state
     //! the init state is LISTENING
@@ -76,6 +78,32 @@ class TCPConnection {
     //! Otherwise, It is a monotonically increasing value in `tick` function
     size_t _time_since_last_seg_received_ms{0};
 
+    //! \name TCP options, negotiated on the SYNs (see TCPOptions)
+    //!@{
+
+    //! Shift for the windows we advertise, large enough to fit `recv_capacity` into 16 bits
+    uint8_t _rcv_window_shift{window_shift_for(_cfg)};
+    //! Shift for the windows the peer advertises
+    uint8_t _snd_window_shift{0};
+    //! Both sides offered window scaling, so every window after the SYNs is scaled
+    bool _window_scaling_ok{false};
+    //! Both sides offered timestamps, so every segment carries them
+    bool _timestamps_ok{false};
+    //! Both sides offered SACK, so our acks carry SACK blocks and the peer's are used
+    bool _sack_ok{false};
+    //! The newest TSval received from the peer in order, echoed back as our TSecr
+    uint32_t _ts_recent{0};
+    //! The ackno of the last segment we sent (Last.ACK.sent), which decides which TSvals are recorded
+    std::optional<WrappingInt32> _last_ack_sent{};
+
+    //! The smallest shift that fits `cfg.recv_capacity` in a 16-bit window (zero without window scaling)
+    static uint8_t window_shift_for(const TCPConfig &cfg);
+    //! Take note of the options in an inbound segment (the negotiation itself happens on SYNs)
+    void options_received(const TCPHeader &header);
+    //! Put our options in an outbound segment, and size its header to fit them
+    void add_options(TCPHeader &header) const;
+    //!@}
+
     //! Send a RST packet, or receive a RST packet
     void send_rst_segment();
     //! unclear shutdown current TCP Connection immediately
@@ -92,9 +120,26 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write data to the outbound byte stream, moving the string in
+    //! \returns the number of bytes from `data` that were actually written.
+    //! \note The outbound stream uses ByteStream::Storage::Ring, so the bytes are copied into it
+    size_t write(std::string &&data);
+
+    //! \brief Write data to the outbound byte stream from a Buffer
+    //! \returns the number of bytes from `data` that were actually written.
+    //! \note The outbound stream uses ByteStream::Storage::Ring, so the bytes are copied into it
+    size_t write(Buffer data);
+
+    //! \brief Read from `fd` directly into the outbound byte stream, and send it over TCP if possible
+    //! \returns the number of bytes that were read from `fd`.
+    size_t write_from(FileDescriptor &fd);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
+    //! \returns `true` if the outbound stream wants more data (see ByteStream::set_watermarks)
+    bool outbound_writable() const { return _sender.stream_in().writable(); }
+
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
     //!@}
@@ -115,6 +160,8 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief Round-trip time estimates, and the retransmission timeout they currently imply
+    RTTEstimator::Stats rtt_stats() const { return _sender.rtt_stats(); }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
@@ -141,7 +188,17 @@ class TCPConnection {
     //!@}
 
     //! Construct a new connection from a configuration
-    explicit TCPConnection(const TCPConfig &cfg) : _cfg{cfg} {}
+    explicit TCPConnection(const TCPConfig &cfg) : _cfg{cfg} {
+        _sender.stream_in().set_watermarks(_cfg.send_low_watermark, _cfg.send_capacity);
+        _receiver.set_memory_budget(_cfg.recv_memory_budget, _cfg.recv_eviction);
+        _sender.set_max_payload_size(_cfg.mss);
+        if (_cfg.adaptive_rto) {
+            _sender.set_adaptive_rto(_cfg.min_rto, _cfg.max_rto);
+        }
+        _sender.set_congestion_control(_cfg.congestion_control);
+        _sender.set_fast_retransmit(_cfg.fast_retransmit);
+        _sender.set_nagle(not _cfg.nodelay);
+    }
 
     //! \name construction and destruction
     //! moving is allowed; copying is disallowed; default construction not possible
@@ -50,7 +50,10 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+
+    PacketBuilder packet{seg.payload()};
+    seg.serialize_header(packet.prepend(4 * seg.header().doff));
+    _sock.sendto(config().destination, packet.finish().str());
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
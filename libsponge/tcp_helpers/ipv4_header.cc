@@ -3,6 +3,8 @@
 #include "util.hh"
 
 #include <arpa/inet.h>
+#include <cstring>
+#include <endian.h>
 #include <iomanip>
 #include <sstream>
 
@@ -28,23 +30,8 @@ ParseResult IPv4Header::parse(NetParser &p) {
         return ParseResult::PacketTooShort;
     }
 
-    const uint8_t first_byte = p.u8();
-    ver = first_byte >> 4;     // version
-    hlen = first_byte & 0x0f;  // header length
-    tos = p.u8();              // type of service
-    len = p.u16();             // length
-    id = p.u16();              // id
-
-    const uint16_t fo_val = p.u16();
-    df = static_cast<bool>(fo_val & 0x4000);  // don't fragment
-    mf = static_cast<bool>(fo_val & 0x2000);  // more fragments
-    offset = fo_val & 0x1fff;                 // offset
-
-    ttl = p.u8();     // ttl
-    proto = p.u8();   // proto
-    cksum = p.u16();  // checksum
-    src = p.u32();    // source address
-    dst = p.u32();    // destination address
+    load(p.buffer().str().data());
+    p.remove_prefix(IPv4Header::LENGTH);
 
     if (data_size < 4 * hlen) {
         return ParseResult::PacketTooShort;
@@ -74,39 +61,98 @@ ParseResult IPv4Header::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
-//! Serialize the IPv4Header to a string (does not recompute the checksum)
-string IPv4Header::serialize() const {
-    // sanity checks
-    if (ver != 4) {
+//! The first `LENGTH` bytes of an IPv4 header as they are laid out on the wire, fields in network byte order
+struct IPv4HeaderWire {
+    uint8_t ver_hlen;
+    uint8_t tos;
+    uint16_t len;
+    uint16_t id;
+    uint16_t flags_offset;
+    uint8_t ttl;
+    uint8_t proto;
+    uint16_t cksum;
+    uint32_t src;
+    uint32_t dst;
+};
+static_assert(sizeof(IPv4HeaderWire) == IPv4Header::LENGTH, "IPv4HeaderWire must match the wire layout");
+
+//! \param[in] wire points to `LENGTH` bytes of a serialized header
+void IPv4Header::load(const char *wire) {
+    IPv4HeaderWire w;
+    memcpy(&w, wire, sizeof(w));
+
+    ver = w.ver_hlen >> 4;     // version
+    hlen = w.ver_hlen & 0x0f;  // header length
+    tos = w.tos;               // type of service
+    len = be16toh(w.len);      // length
+    id = be16toh(w.id);        // id
+
+    const uint16_t fo_val = be16toh(w.flags_offset);
+    df = static_cast<bool>(fo_val & 0x4000);  // don't fragment
+    mf = static_cast<bool>(fo_val & 0x2000);  // more fragments
+    offset = fo_val & 0x1fff;                 // offset
+
+    ttl = w.ttl;               // ttl
+    proto = w.proto;           // proto
+    cksum = be16toh(w.cksum);  // checksum
+    src = be32toh(w.src);      // source address
+    dst = be32toh(w.dst);      // destination address
+}
+
+//! \param[out] wire receives the first `LENGTH` bytes of the serialized header
+void IPv4Header::store(char *wire) const {
+    IPv4HeaderWire w;
+    w.ver_hlen = (ver << 4) | (hlen & 0xf);
+    w.tos = tos;
+    w.len = htobe16(len);
+    w.id = htobe16(id);
+    w.flags_offset = htobe16((df ? 0x4000 : 0) | (mf ? 0x2000 : 0) | (offset & 0x1fff));
+    w.ttl = ttl;
+    w.proto = proto;
+    w.cksum = htobe16(cksum);
+    w.src = htobe32(src);
+    w.dst = htobe32(dst);
+    memcpy(wire, &w, sizeof(w));
+}
+
+//! Throw std::runtime_error unless the header's version and length can be serialized
+static void check_serializable(const IPv4Header &header) {
+    if (header.ver != 4) {
         throw runtime_error("wrong IP version");
     }
-    if (4 * hlen < IPv4Header::LENGTH) {
+    if (4 * header.hlen < IPv4Header::LENGTH) {
         throw runtime_error("IP header too short");
     }
+}
 
-    string ret;
-    ret.reserve(4 * hlen);
-
-    const uint8_t first_byte = (ver << 4) | (hlen & 0xf);
-    NetUnparser::u8(ret, first_byte);  // version and header length
-    NetUnparser::u8(ret, tos);         // type of service
-    NetUnparser::u16(ret, len);        // length
-    NetUnparser::u16(ret, id);         // id
-
-    const uint16_t fo_val = (df ? 0x4000 : 0) | (mf ? 0x2000 : 0) | (offset & 0x1fff);
-    NetUnparser::u16(ret, fo_val);  // flags and offset
+//! Serialize the IPv4Header to a string (does not recompute the checksum)
+string IPv4Header::serialize() const {
+    check_serializable(*this);
 
-    NetUnparser::u8(ret, ttl);    // time to live
-    NetUnparser::u8(ret, proto);  // protocol number
+    string ret = BufferPool::take();
+    ret.resize(4 * hlen);  // the header at its advertised size; any options are left zero
+    store(ret.data());
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    return ret;
+}
 
-    NetUnparser::u32(ret, src);  // src address
-    NetUnparser::u32(ret, dst);  // dst address
+//! \details The header is written once with a zero checksum, summed in place, and then the
+//! checksum field is patched.
+//! \param[out] wire receives the `4 * hlen` bytes of the header, options zeroed
+void IPv4Header::serialize_checksummed(char *wire) const {
+    check_serializable(*this);
 
-    ret.resize(4 * hlen);  // expand header to advertised size
+    const size_t header_length = 4 * hlen;
+    IPv4Header header_out = *this;
+    header_out.cksum = 0;
+    header_out.store(wire);
+    memset(wire + LENGTH, 0, header_length - LENGTH);
 
-    return ret;
+    // calculate checksum -- taken over header only
+    InternetChecksum check;
+    check.add(string_view{wire, header_length});
+    const uint16_t checksum = htobe16(check.value());
+    memcpy(wire + 10, &checksum, sizeof(checksum));  // the checksum field's offset in the header
 }
 
 uint16_t IPv4Header::payload_length() const { return len - 4 * hlen; }
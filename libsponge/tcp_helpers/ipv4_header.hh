@@ -49,9 +49,19 @@ struct IPv4Header {
     //! Parse the IP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
+    //! \name Fixed-layout codec for the first `LENGTH` bytes of the header
+    //! Each is one memcpy of the whole header plus byte swaps; the caller supplies `LENGTH` bytes.
+    //!@{
+    void load(const char *wire);
+    void store(char *wire) const;
+    //!@}
+
     //! Serialize the IP fields
     std::string serialize() const;
 
+    //! Serialize the IP fields into `4 * hlen` bytes at `wire`, computing the checksum rather than using `cksum`
+    void serialize_checksummed(char *wire) const;
+
     //! Length of the payload
     uint16_t payload_length() const;
 
@@ -36,6 +36,9 @@ class LossyFdAdapter {
     //! Construct from a FileDescriptor appropriate to the AdapterT constructor
     explicit LossyFdAdapter(AdapterT &&adapter) : _adapter(std::move(adapter)) {}
 
+    //! Draw the drops from a generator seeded with `seed`, so that a run can be repeated exactly
+    void seed(const std::mt19937::result_type seed) { _rand.seed(seed); }
+
     //! \brief Read from the underlying AdapterT instance, potentially dropping the read datagram
     //! \returns std::optional<TCPSegment> that is empty if the segment was dropped or if
     //!          the underlying AdapterT returned an empty value
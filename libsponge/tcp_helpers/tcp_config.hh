@@ -2,6 +2,8 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "congestion_control.hh"
+#include "stream_reassembler.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -15,11 +17,43 @@ class TCPConfig {
     static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr unsigned DUP_ACK_THRESHOLD = 3;   //!< Duplicate acks that trigger a fast retransmit
+    static constexpr uint16_t MIN_RTO_DFLT = 200;      //!< Default lower bound on an adaptive RTO
+    static constexpr uint16_t MAX_RTO_DFLT = 60000;    //!< Default upper bound on an adaptive RTO
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
+    //! Adapt the retransmission timeout to measured round-trip times (RFC 6298), within `[min_rto, max_rto]`
+    //! milliseconds; otherwise every ack of new data resets it to `rt_timeout` (what the lab tests expect)
+    bool adaptive_rto = false;
+    uint16_t min_rto = MIN_RTO_DFLT;  //!< Smallest adaptive retransmission timeout, in milliseconds
+    uint16_t max_rto = MAX_RTO_DFLT;  //!< Largest adaptive retransmission timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
+    //! How the inbound stream holds bytes. Storage::Chunked keeps each in-order payload as the segment's own
+    //! Buffer; the default Storage::Ring copies it into a ring allocated up front.
+    ByteStream::Storage recv_storage = ByteStream::Storage::Ring;
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    //! Once the outbound stream fills up, it accepts writes again only after draining to this many bytes
+    size_t send_low_watermark = DEFAULT_CAPACITY / 2;
+    //! Most memory the receiver may hold for out-of-order bytes, bookkeeping included
+    size_t recv_memory_budget = 4 * DEFAULT_CAPACITY;
+    //! How the receiver gets back under `recv_memory_budget`
+    StreamReassembler::Eviction recv_eviction = StreamReassembler::Eviction::Coalesce;
     std::optional<WrappingInt32> fixed_isn{};
+    //! Largest payload we send in one segment, and the MSS option we advertise (a smaller MSS from the peer wins)
+    uint16_t mss = MAX_PAYLOAD_SIZE;
+    //! Offer window scaling (RFC 7323), so that a `recv_capacity` past 64 KiB can be advertised in full
+    bool window_scaling = true;
+    //! Offer timestamps (RFC 7323) on every segment
+    bool timestamps = true;
+    //! Offer selective acknowledgments (RFC 2018), so fast recovery can resend just the missing segments
+    bool sack = true;
+    //! How the sender limits its data in flight beyond the peer's window (no congestion window by default)
+    CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None;
+    //! Retransmit on DUP_ACK_THRESHOLD duplicate acks, then do fast recovery, instead of waiting for the timer
+    bool fast_retransmit = true;
+    //! Send every write at once, like TCP_NODELAY (what the lab tests expect); otherwise small writes are
+    //! coalesced with Nagle's algorithm
+    bool nodelay = true;
 };
 
 //! Config for classes derived from FdAdapter
@@ -1,6 +1,10 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
+#include <cstring>
+#include <endian.h>
 #include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -15,30 +19,22 @@ using namespace std;
 //! - there is less data in the header than the `doff` field claims
 //! - the checksum is bad
 ParseResult TCPHeader::parse(NetParser &p) {
-    sport = p.u16();                 // source port
-    dport = p.u16();                 // destination port
-    seqno = WrappingInt32{p.u32()};  // sequence number
-    ackno = WrappingInt32{p.u32()};  // ack number
-    doff = p.u8() >> 4;              // data offset
-
-    const uint8_t fl_b = p.u8();                  // byte including flags
-    urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
-    ack = static_cast<bool>(fl_b & 0b0001'0000);
-    psh = static_cast<bool>(fl_b & 0b0000'1000);
-    rst = static_cast<bool>(fl_b & 0b0000'0100);
-    syn = static_cast<bool>(fl_b & 0b0000'0010);
-    fin = static_cast<bool>(fl_b & 0b0000'0001);
-
-    win = p.u16();    // window size
-    cksum = p.u16();  // checksum
-    uptr = p.u16();   // urgent pointer
+    if (p.buffer().size() < TCPHeader::LENGTH) {
+        p.set_error(ParseResult::PacketTooShort);
+        return p.get_error();
+    }
+    load(p.buffer().str().data());
+    p.remove_prefix(TCPHeader::LENGTH);
 
     if (doff < 5) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // decode the options we understand, and skip the rest of the header
+    const size_t options_length = doff * 4 - TCPHeader::LENGTH;
+    options = {};
+    options.parse(p.buffer().str().substr(0, options_length));
+    p.remove_prefix(options_length);
 
     if (p.error()) {
         return p.get_error();
@@ -47,32 +43,206 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
-//! Serialize the TCPHeader to a string (does not recompute the checksum)
-string TCPHeader::serialize() const {
-    // sanity check
-    if (doff < 5) {
-        throw runtime_error("TCP header too short");
+//! \name Option kinds, and the length of each option we understand
+//!@{
+static constexpr uint8_t OPTION_END = 0;
+static constexpr uint8_t OPTION_NOP = 1;
+static constexpr uint8_t OPTION_MSS = 2;
+static constexpr uint8_t OPTION_MSS_LENGTH = 4;
+static constexpr uint8_t OPTION_WINDOW_SCALE = 3;
+static constexpr uint8_t OPTION_WINDOW_SCALE_LENGTH = 3;
+static constexpr uint8_t OPTION_SACK_PERMITTED = 4;
+static constexpr uint8_t OPTION_SACK_PERMITTED_LENGTH = 2;
+static constexpr uint8_t OPTION_SACK = 5;
+static constexpr uint8_t OPTION_SACK_BLOCK_LENGTH = 8;  //!< Each block; the option adds 2 bytes of kind and length
+static constexpr uint8_t OPTION_TIMESTAMPS = 8;
+static constexpr uint8_t OPTION_TIMESTAMPS_LENGTH = 10;
+//!@}
+
+//! Bytes of option space in a header with the largest `doff`
+static constexpr size_t OPTIONS_SPACE = 40;
+
+//! Bytes taken by all the options but the SACK blocks
+static size_t length_without_sack(const TCPOptions &options) {
+    return (options.mss ? 4 : 0) + (options.window_scale ? 4 : 0) + (options.timestamps ? 12 : 0) +
+           (options.sack_permitted ? 4 : 0);
+}
+
+//! \details Each option is padded with leading NOPs to a multiple of 4 bytes, so the 32-bit fields that
+//! follow it stay aligned (the layout Linux uses).
+size_t TCPOptions::length() const {
+    return length_without_sack(*this) + (sack.empty() ? 0 : 4 + OPTION_SACK_BLOCK_LENGTH * sack.size());
+}
+
+size_t TCPOptions::sack_capacity() const {
+    const size_t space = OPTIONS_SPACE - length_without_sack(*this);
+    return space < 4 + OPTION_SACK_BLOCK_LENGTH ? 0 : min((space - 4) / OPTION_SACK_BLOCK_LENGTH, MAX_SACK_BLOCKS);
+}
+
+//! \param[in] wire the bytes of the options area
+void TCPOptions::parse(const string_view wire) {
+    size_t i = 0;
+    while (i < wire.size()) {
+        const uint8_t kind = wire[i];
+        if (kind == OPTION_END) {
+            return;
+        }
+        if (kind == OPTION_NOP) {
+            i++;
+            continue;
+        }
+        if (i + 1 >= wire.size()) {
+            return;
+        }
+        const uint8_t length = wire[i + 1];
+        if (length < 2 or i + length > wire.size()) {
+            return;  // malformed: nothing after it can be trusted
+        }
+
+        const char *value = wire.data() + i + 2;
+        if (kind == OPTION_MSS and length == OPTION_MSS_LENGTH) {
+            uint16_t v;
+            memcpy(&v, value, sizeof(v));
+            mss = be16toh(v);
+        } else if (kind == OPTION_WINDOW_SCALE and length == OPTION_WINDOW_SCALE_LENGTH) {
+            window_scale = min(static_cast<uint8_t>(value[0]), MAX_WINDOW_SCALE);
+        } else if (kind == OPTION_TIMESTAMPS and length == OPTION_TIMESTAMPS_LENGTH) {
+            uint32_t v[2];
+            memcpy(v, value, sizeof(v));
+            timestamps = Timestamps{be32toh(v[0]), be32toh(v[1])};
+        } else if (kind == OPTION_SACK_PERMITTED and length == OPTION_SACK_PERMITTED_LENGTH) {
+            sack_permitted = true;
+        } else if (kind == OPTION_SACK and length > 2 and (length - 2) % OPTION_SACK_BLOCK_LENGTH == 0) {
+            sack.clear();
+            for (const char *block = value; block < wire.data() + i + length; block += OPTION_SACK_BLOCK_LENGTH) {
+                uint32_t v[2];
+                memcpy(v, block, sizeof(v));
+                sack.push_back({WrappingInt32{be32toh(v[0])}, WrappingInt32{be32toh(v[1])}});
+            }
+        }
+        i += length;
     }
+}
 
-    string ret;
-    ret.reserve(4 * doff);
+//! \param[out] wire receives the options, then zeros up to `space` bytes
+//! \param[in] space size of the options area
+void TCPOptions::store(char *wire, const size_t space) const {
+    if (length() > space) {
+        throw runtime_error("TCP options don't fit in the header");
+    }
 
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    char *out = wire;
+    if (mss) {
+        const uint16_t v = htobe16(*mss);
+        *out++ = OPTION_MSS;
+        *out++ = OPTION_MSS_LENGTH;
+        memcpy(out, &v, sizeof(v));
+        out += sizeof(v);
+    }
+    if (window_scale) {
+        *out++ = OPTION_NOP;
+        *out++ = OPTION_WINDOW_SCALE;
+        *out++ = OPTION_WINDOW_SCALE_LENGTH;
+        *out++ = *window_scale;
+    }
+    if (timestamps) {
+        const uint32_t v[2] = {htobe32(timestamps->value), htobe32(timestamps->echo_reply)};
+        *out++ = OPTION_NOP;
+        *out++ = OPTION_NOP;
+        *out++ = OPTION_TIMESTAMPS;
+        *out++ = OPTION_TIMESTAMPS_LENGTH;
+        memcpy(out, v, sizeof(v));
+        out += sizeof(v);
+    }
+    if (sack_permitted) {
+        *out++ = OPTION_NOP;
+        *out++ = OPTION_NOP;
+        *out++ = OPTION_SACK_PERMITTED;
+        *out++ = OPTION_SACK_PERMITTED_LENGTH;
+    }
+    if (not sack.empty()) {
+        *out++ = OPTION_NOP;
+        *out++ = OPTION_NOP;
+        *out++ = OPTION_SACK;
+        *out++ = 2 + OPTION_SACK_BLOCK_LENGTH * sack.size();
+        for (const auto &block : sack) {
+            const uint32_t v[2] = {htobe32(block.left.raw_value()), htobe32(block.right.raw_value())};
+            memcpy(out, v, sizeof(v));
+            out += sizeof(v);
+        }
+    }
+    memset(out, OPTION_END, space - (out - wire));
+}
+
+bool TCPOptions::operator==(const TCPOptions &other) const {
+    return mss == other.mss and window_scale == other.window_scale and timestamps == other.timestamps and
+           sack_permitted == other.sack_permitted and sack == other.sack;
+}
+
+//! The first `LENGTH` bytes of a TCP header as they are laid out on the wire, fields in network byte order
+struct TCPHeaderWire {
+    uint16_t sport;
+    uint16_t dport;
+    uint32_t seqno;
+    uint32_t ackno;
+    uint8_t doff;  // in the high nibble
+    uint8_t flags;
+    uint16_t win;
+    uint16_t cksum;
+    uint16_t uptr;
+};
+static_assert(sizeof(TCPHeaderWire) == TCPHeader::LENGTH, "TCPHeaderWire must match the wire layout");
 
-    const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
-                         (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
+//! \param[in] wire points to `LENGTH` bytes of a serialized header
+void TCPHeader::load(const char *wire) {
+    TCPHeaderWire w;
+    memcpy(&w, wire, sizeof(w));
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    sport = be16toh(w.sport);                 // source port
+    dport = be16toh(w.dport);                 // destination port
+    seqno = WrappingInt32{be32toh(w.seqno)};  // sequence number
+    ackno = WrappingInt32{be32toh(w.ackno)};  // ack number
+    doff = w.doff >> 4;                       // data offset
 
-    NetUnparser::u16(ret, uptr);  // urgent pointer
+    urg = static_cast<bool>(w.flags & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
+    ack = static_cast<bool>(w.flags & 0b0001'0000);
+    psh = static_cast<bool>(w.flags & 0b0000'1000);
+    rst = static_cast<bool>(w.flags & 0b0000'0100);
+    syn = static_cast<bool>(w.flags & 0b0000'0010);
+    fin = static_cast<bool>(w.flags & 0b0000'0001);
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    win = be16toh(w.win);      // window size
+    cksum = be16toh(w.cksum);  // checksum
+    uptr = be16toh(w.uptr);    // urgent pointer
+}
+
+//! \param[out] wire receives the first `LENGTH` bytes of the serialized header
+void TCPHeader::store(char *wire) const {
+    TCPHeaderWire w;
+    w.sport = htobe16(sport);
+    w.dport = htobe16(dport);
+    w.seqno = htobe32(seqno.raw_value());
+    w.ackno = htobe32(ackno.raw_value());
+    w.doff = doff << 4;
+    w.flags = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
+              (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
+    w.win = htobe16(win);
+    w.cksum = htobe16(cksum);
+    w.uptr = htobe16(uptr);
+    memcpy(wire, &w, sizeof(w));
+}
+
+//! Serialize the TCPHeader to a string (does not recompute the checksum)
+string TCPHeader::serialize() const {
+    // sanity check
+    if (doff < 5) {
+        throw runtime_error("TCP header too short");
+    }
+
+    string ret = BufferPool::take();
+    ret.resize(4 * doff);  // the header at its advertised size
+    store(ret.data());
+    store_options(ret.data() + LENGTH);
 
     return ret;
 }
@@ -90,6 +260,21 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (options.mss) {
+        ss << "TCP MSS: " << dec << *options.mss << hex << '\n';
+    }
+    if (options.window_scale) {
+        ss << "TCP window scale: " << +*options.window_scale << '\n';
+    }
+    if (options.timestamps) {
+        ss << "TCP timestamps: " << options.timestamps->value << ", echo " << options.timestamps->echo_reply << '\n';
+    }
+    if (options.sack_permitted) {
+        ss << "TCP SACK permitted\n";
+    }
+    for (const auto &block : options.sack) {
+        ss << "TCP SACK block: " << block.left << "-" << block.right << '\n';
+    }
     return ss.str();
 }
 
@@ -104,5 +289,5 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && options == other.options;
 }
@@ -4,8 +4,60 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+//! \brief The TCP options this implementation understands: MSS (RFC 793), window scale and timestamps (RFC 7323),
+//! and selective acknowledgments (RFC 2018)
+//! \details Parsing skips any other option, and stops at the first malformed one.
+struct TCPOptions {
+    //! Timestamps option: the sender's clock, and the most recent clock value it received from its peer
+    struct Timestamps {
+        uint32_t value = 0;       //!< TSval
+        uint32_t echo_reply = 0;  //!< TSecr
+
+        bool operator==(const Timestamps &other) const {
+            return value == other.value and echo_reply == other.echo_reply;
+        }
+    };
+
+    //! SACK block: a run of sequence space the receiver holds beyond the ackno, from `left` up to (not including)
+    //! `right`
+    struct SackBlock {
+        WrappingInt32 left{0};
+        WrappingInt32 right{0};
+
+        bool operator==(const SackBlock &other) const { return left == other.left and right == other.right; }
+    };
+
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;  //!< Largest shift count RFC 7323 allows
+    static constexpr size_t MAX_SACK_BLOCKS = 4;     //!< Most SACK blocks that fit in the options area
+
+    std::optional<uint16_t> mss{};           //!< Maximum segment size the sender can receive (SYN only)
+    std::optional<uint8_t> window_scale{};   //!< Shift count for the sender's window field (SYN only)
+    std::optional<Timestamps> timestamps{};  //!< Timestamps, for RTT measurement and PAWS
+    bool sack_permitted = false;             //!< The sender can receive SACK blocks (SYN only)
+    std::vector<SackBlock> sack{};           //!< SACK blocks, the most recently changed first
+
+    //! Most SACK blocks that fit alongside the other options (three with timestamps, otherwise four)
+    size_t sack_capacity() const;
+
+    //! Number of bytes the options take in the header, padding included (always a multiple of 4)
+    size_t length() const;
+
+    //! Parse the options area of a header (the bytes between its first `TCPHeader::LENGTH` and `4 * doff`)
+    void parse(std::string_view wire);
+
+    //! Serialize into `space` bytes at `wire`, padding the rest with zeros (end of option list)
+    //! \throws std::runtime_error if the options need more than `space` bytes
+    void store(char *wire, const size_t space) const;
+
+    bool operator==(const TCPOptions &other) const;
+};
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
 
@@ -50,9 +102,25 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! Options, carried in the `4 * doff - LENGTH` bytes after the fixed header
+    TCPOptions options{};
+
+    //! Set `doff` to the smallest header that holds `options`
+    void fit_options() { doff = (LENGTH + options.length()) / 4; }
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
+    //! \name Fixed-layout codec for the first `LENGTH` bytes of the header
+    //! Each is one memcpy of the whole header plus byte swaps; the caller supplies `LENGTH` bytes.
+    //!@{
+    void load(const char *wire);
+    void store(char *wire) const;
+    //!@}
+
+    //! Serialize the options into the `4 * doff - LENGTH` bytes at `wire` (right after the fixed header)
+    void store_options(char *wire) const { options.store(wire, 4 * doff - LENGTH); }
+
     //! Serialize the TCP fields
     std::string serialize() const;
 
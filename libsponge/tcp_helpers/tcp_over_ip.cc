@@ -11,12 +11,12 @@
 
 using namespace std;
 
-//! \details This function attempts to parse a TCP segment from
-//! the IP datagram's payload.
+//! \details This function views the IP datagram's payload as a TCP segment.
 //!
-//! If this succeeds, it then checks that the received segment is related to the
-//! current connection. When a TCP connection has been established, this means
-//! checking that the source and destination ports in the TCP header are correct.
+//! It first checks that the segment is related to the current connection, reading only the
+//! header fields it needs. When a TCP connection has been established, this means checking
+//! that the source and destination ports in the TCP header are correct. Only a segment that
+//! passes has its checksum verified and its header fully decoded.
 //!
 //! If the TCP connection is listening (i.e., TCPOverIPv4OverTunFdAdapter::_listen is `true`)
 //! and the TCP segment read from the wire includes a SYN, this function clears the
@@ -40,51 +40,76 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
         return {};
     }
 
-    // is the payload a valid TCP segment?
-    TCPSegment tcp_seg;
-    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+    // is the payload long enough to hold a TCP header?
+    const TCPSegmentView tcp_view{ip_dgram.payload()};
+    if (ParseResult::NoError != tcp_view.validate()) {
         return {};
     }
 
     // is the TCP segment for us?
-    if (tcp_seg.header().dport != config().source.port()) {
+    if (tcp_view.dport() != config().source.port()) {
         return {};
     }
 
-    // should we target this source addr/port (and use its destination addr as our source) in reply?
+    // is the TCP segment from our peer? (or, if listening, does it open a connection?)
     if (listening()) {
-        if (tcp_seg.header().syn and not tcp_seg.header().rst) {
-            config_mutable().source = {inet_ntoa({htobe32(ip_dgram.header().dst)}), config().source.port()};
-            config_mutable().destination = {inet_ntoa({htobe32(ip_dgram.header().src)}), tcp_seg.header().sport};
-            set_listening(false);
-        } else {
+        if (not tcp_view.syn() or tcp_view.rst()) {
             return {};
         }
+    } else if (tcp_view.sport() != config().destination.port()) {
+        return {};
     }
 
-    // is the TCP segment from our peer?
-    if (tcp_seg.header().sport != config().destination.port()) {
+    // is the payload a valid TCP segment?
+    if (not tcp_view.checksum_ok(ip_dgram.header().pseudo_cksum())) {
         return {};
     }
 
-    return tcp_seg;
+    // should we target this source addr/port (and use its destination addr as our source) in reply?
+    if (listening()) {
+        config_mutable().source = {inet_ntoa({htobe32(ip_dgram.header().dst)}), config().source.port()};
+        config_mutable().destination = {inet_ntoa({htobe32(ip_dgram.header().src)}), tcp_view.sport()};
+        set_listening(false);
+    }
+
+    return tcp_view.segment();
 }
 
-//! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
-//! \param[in] seg is the TCP segment to convert
-InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
+//! \param[in,out] seg is the TCP segment to be carried; its port numbers are set from the config
+IPv4Header TCPOverIPv4Adapter::address_tcp_in_ip(TCPSegment &seg) const {
     // set the port numbers in the TCP segment
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
 
-    // create an Internet Datagram and set its addresses and length
+    // set the datagram's addresses and length
+    IPv4Header ip_header;
+    ip_header.src = config().source.ipv4_numeric();
+    ip_header.dst = config().destination.ipv4_numeric();
+    ip_header.len = ip_header.hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    return ip_header;
+}
+
+//! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
+//! \param[in] seg is the TCP segment to convert
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
     InternetDatagram ip_dgram;
-    ip_dgram.header().src = config().source.ipv4_numeric();
-    ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    ip_dgram.header() = address_tcp_in_ip(seg);
 
     // set payload, calculating TCP checksum using information from IP header
     ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
 
     return ip_dgram;
 }
+
+//! \details The payload is copied once into a pooled packet buffer, and both headers are then
+//! written in place in front of it, so the result can go to the TUN device in a single write.
+//! \param[in] seg is the TCP segment to convert
+//! \returns the serialized IPv4 datagram
+Buffer TCPOverIPv4Adapter::serialize_tcp_in_ip(TCPSegment &seg) {
+    const IPv4Header ip_header = address_tcp_in_ip(seg);
+
+    PacketBuilder packet{seg.payload()};
+    seg.serialize_header(packet.prepend(4 * seg.header().doff), ip_header.pseudo_cksum());
+    ip_header.serialize_checksummed(packet.prepend(4 * ip_header.hlen));
+    return packet.finish();
+}
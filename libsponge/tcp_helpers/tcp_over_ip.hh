@@ -10,10 +10,17 @@
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
+  private:
+    //! Set the segment's port numbers, and make the IPv4 header that carries it
+    IPv4Header address_tcp_in_ip(TCPSegment &seg) const;
+
   public:
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! Like wrap_tcp_in_ip(), but serialized straight into one contiguous packet
+    Buffer serialize_tcp_in_ip(TCPSegment &seg);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
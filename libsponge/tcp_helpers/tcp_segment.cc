@@ -3,6 +3,9 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <cstring>
+#include <endian.h>
+#include <stdexcept>
 #include <variant>
 
 using namespace std;
@@ -26,20 +29,118 @@ size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+void TCPSegment::set_payload(Buffer payload, const uint32_t payload_sum) {
+    _payload = move(payload);
+    _summed_payload = _payload;
+    _payload_sum = payload_sum;
+}
+
+uint32_t TCPSegment::payload_sum() const {
+    const string_view summed = _summed_payload.str();
+    const string_view payload = _payload.str();
+    if (summed.data() != payload.data() or summed.size() != payload.size()) {
+        InternetChecksum check;
+        check.add(payload);
+        _payload_sum = check.sum();
+        _summed_payload = _payload;
+    }
+    return _payload_sum;
+}
+
+//! \details Retransmitting a segment only sums its header again: the payload's sum is cached.
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
+    string header = BufferPool::take();
+    header.resize(4 * _header.doff);
+    serialize_header(header.data(), datagram_layer_checksum);
+
+    BufferList ret;
+    ret.append(move(header));
+    ret.append(_payload);
+
+    return ret;
+}
+
+//! \details The header is written once with a zero checksum, summed in place, and then the
+//! checksum field is patched; the payload's sum is cached as for serialize().
+//! \param[out] wire receives the `4 * doff` bytes of the header
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+void TCPSegment::serialize_header(char *wire, const uint32_t datagram_layer_checksum) const {
+    // sanity check
+    if (_header.doff < 5) {
+        throw runtime_error("TCP header too short");
+    }
+
+    const size_t header_length = 4 * _header.doff;
     TCPHeader header_out = _header;
     header_out.cksum = 0;
+    header_out.store(wire);
+    header_out.store_options(wire + TCPHeader::LENGTH);
 
     // calculate checksum -- taken over entire segment
     InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
-    check.add(_payload);
-    header_out.cksum = check.value();
+    check.add(string_view{wire, header_length});
+    check.add_sum(payload_sum());
+    const uint16_t cksum = htobe16(check.value());
+    memcpy(wire + 16, &cksum, sizeof(cksum));  // the checksum field's offset in the header
+}
 
-    BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
+uint16_t TCPSegmentView::u16(const size_t offset) const {
+    uint16_t value;
+    memcpy(&value, _buffer.str().data() + offset, sizeof(value));
+    return be16toh(value);
+}
+
+uint32_t TCPSegmentView::u32(const size_t offset) const {
+    uint32_t value;
+    memcpy(&value, _buffer.str().data() + offset, sizeof(value));
+    return be32toh(value);
+}
 
+//! \returns the same errors TCPSegment::parse() would, apart from BadChecksum
+ParseResult TCPSegmentView::validate() const {
+    if (_buffer.size() < TCPHeader::LENGTH) {
+        return ParseResult::PacketTooShort;
+    }
+    if (doff() < 5) {
+        return ParseResult::HeaderTooShort;
+    }
+    if (_buffer.size() < doff() * 4ul) {
+        return ParseResult::PacketTooShort;
+    }
+    return ParseResult::NoError;
+}
+
+bool TCPSegmentView::checksum_ok(const uint32_t datagram_layer_checksum) const {
+    InternetChecksum check(datagram_layer_checksum);
+    check.add(_buffer);
+    return check.value() == 0;
+}
+
+Buffer TCPSegmentView::payload() const {
+    Buffer ret = _buffer;
+    ret.remove_prefix(doff() * 4);
     return ret;
 }
+
+TCPSegment TCPSegmentView::segment() const {
+    TCPSegment seg;
+    TCPHeader &header = seg.header();
+    header.sport = sport();
+    header.dport = dport();
+    header.seqno = seqno();
+    header.ackno = ackno();
+    header.doff = doff();
+    header.urg = urg();
+    header.ack = ack();
+    header.psh = psh();
+    header.rst = rst();
+    header.syn = syn();
+    header.fin = fin();
+    header.win = win();
+    header.cksum = cksum();
+    header.uptr = uptr();
+    header.options.parse(_buffer.str().substr(TCPHeader::LENGTH, doff() * 4 - TCPHeader::LENGTH));
+    seg.payload() = payload();
+    return seg;
+}
@@ -5,6 +5,7 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <utility>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
@@ -12,6 +13,17 @@ class TCPSegment {
     TCPHeader _header{};
     Buffer _payload{};
 
+    //! \name Partial checksum of the payload, reused while the payload is unchanged
+    //! Buffers never change their bytes, and holding on to the summed one keeps its storage from
+    //! being reused, so the payload is unchanged exactly when it still views the same bytes.
+    //!@{
+    mutable Buffer _summed_payload{};
+    mutable uint32_t _payload_sum{0};
+    //!@}
+
+    //! The payload's partial checksum, computed only if the payload changed since it was last summed
+    uint32_t payload_sum() const;
+
   public:
     //! \brief Parse the segment from a string
     ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
@@ -19,6 +31,10 @@ class TCPSegment {
     //! \brief Serialize the segment to a string
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Serialize just the header, checksum included, into `4 * header().doff` bytes at `wire`
+    //! \details For building the packet in place (see PacketBuilder): the payload goes right after.
+    void serialize_header(char *wire, const uint32_t datagram_layer_checksum = 0) const;
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
@@ -28,9 +44,62 @@ class TCPSegment {
     Buffer &payload() { return _payload; }
     //!@}
 
+    //! \brief Set the payload along with its partial checksum (InternetChecksum::sum() over exactly its bytes)
+    //! \details serialize() then uses `payload_sum` instead of summing the payload itself.
+    void set_payload(Buffer payload, const uint32_t payload_sum);
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
 };
 
+//! \brief A serialized [TCP](\ref rfc::rfc793) segment whose header fields are decoded only when asked for
+//! \details Cheap enough to construct for every datagram a demultiplexer looks at: the fields are read
+//! straight from the network-order bytes, and the checksum is only verified by checksum_ok().
+class TCPSegmentView {
+  private:
+    Buffer _buffer;
+
+    uint8_t u8(const size_t offset) const { return _buffer.str()[offset]; }
+    uint16_t u16(const size_t offset) const;
+    uint32_t u32(const size_t offset) const;
+    bool flag(const uint8_t mask) const { return u8(13) & mask; }
+
+  public:
+    //! \brief View the serialized segment in `buffer` (sharing its storage)
+    explicit TCPSegmentView(Buffer buffer) : _buffer(std::move(buffer)) {}
+
+    //! \brief Check that the header fits and its data offset is sane (but not the checksum)
+    //! \note The field accessors may only be used once this returns ParseResult::NoError
+    ParseResult validate() const;
+
+    //! \brief Verify the checksum over the whole segment
+    //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+    bool checksum_ok(const uint32_t datagram_layer_checksum = 0) const;
+
+    //! \name Header fields, decoded on each call
+    //!@{
+    uint16_t sport() const { return u16(0); }
+    uint16_t dport() const { return u16(2); }
+    WrappingInt32 seqno() const { return WrappingInt32{u32(4)}; }
+    WrappingInt32 ackno() const { return WrappingInt32{u32(8)}; }
+    uint8_t doff() const { return u8(12) >> 4; }
+    bool urg() const { return flag(0b0010'0000); }
+    bool ack() const { return flag(0b0001'0000); }
+    bool psh() const { return flag(0b0000'1000); }
+    bool rst() const { return flag(0b0000'0100); }
+    bool syn() const { return flag(0b0000'0010); }
+    bool fin() const { return flag(0b0000'0001); }
+    uint16_t win() const { return u16(14); }
+    uint16_t cksum() const { return u16(16); }
+    uint16_t uptr() const { return u16(18); }
+    //!@}
+
+    //! The bytes after the header (and any options), sharing the viewed storage
+    Buffer payload() const;
+
+    //! Decode every field into a TCPSegment
+    TCPSegment segment() const;
+};
+
 #endif  // SPONGE_LIBSPONGE_TCP_SEGMENT_HH
@@ -27,7 +27,7 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     }
 
     //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    void write(TCPSegment &seg) { _tun.write(serialize_tcp_in_ip(seg).str()); }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
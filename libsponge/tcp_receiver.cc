@@ -1,5 +1,8 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+#include <limits>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -32,7 +35,10 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     uint64_t absolute_seqno = unwrap(hdr.seqno, _isn, ckpt);
     // In the first segment, the stream index should be 0, or this index should be absolute seqno minus 1
     uint64_t stream_idx = absolute_seqno + static_cast<uint64_t>(hdr.syn) - 1;
-    _reassembler.push_substring(data.copy(), stream_idx, _fin);
+    if (stream_idx > stream_out().bytes_written() and data.size() > 0) {
+        _latest_out_of_order = stream_idx;
+    }
+    _reassembler.push_substring(data, stream_idx, hdr.fin);
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -41,8 +47,8 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
     }
     // written bytes + SYN
     uint64_t absolute_ackno = stream_out().bytes_written() + 1;
-    // Only when there is no segment on the fly and receive the FIN flag, then the absolute seq add 1
-    absolute_ackno += (_fin && _reassembler.unassembled_bytes() == 0) ? 1 : 0;
+    // Only once every byte up to the FIN has been reassembled does the FIN itself count
+    absolute_ackno += stream_out().input_ended() ? 1 : 0;
     return wrap(absolute_ackno, _isn);
 }
 
@@ -50,3 +56,31 @@ size_t TCPReceiver::window_size() const {
     // the capacity minus the bytes have been reassembled, but not consumed
     return this->_capacity - this->stream_out().buffer_size();
 }
+
+//! \details The blocks after the first are in ascending order, nearest the ackno first.
+vector<TCPOptions::SackBlock> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<TCPOptions::SackBlock> blocks;
+    if (!_syn) {
+        return blocks;
+    }
+    auto ranges = _reassembler.pending_ranges();
+    if (_latest_out_of_order.has_value()) {
+        const uint64_t latest = _latest_out_of_order.value();
+        const auto holding = find_if(ranges.begin(), ranges.end(), [&](const auto &range) {
+            return range.first <= latest and latest < range.second;
+        });
+        if (holding != ranges.end()) {
+            rotate(ranges.begin(), holding, holding + 1);
+        }
+    }
+    for (size_t i = 0; i < ranges.size() and i < max_blocks; i++) {
+        // a stream index is one less than its absolute seqno, which counts the SYN
+        blocks.push_back({wrap(ranges[i].first + 1, _isn), wrap(ranges[i].second + 1, _isn)});
+    }
+    return blocks;
+}
+
+uint16_t TCPReceiver::advertised_window(const bool syn) const {
+    const size_t scaled = window_size() >> (syn ? 0 : _window_shift);
+    return min<size_t>(scaled, numeric_limits<uint16_t>::max());
+}
@@ -7,6 +7,7 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -25,12 +26,20 @@ class TCPReceiver {
     //! The maximum number of bytes we'll store.
     size_t _capacity;
 
+    //! How far the advertised window is shifted right, once window scaling is negotiated
+    uint8_t _window_shift{0};
+
+    //! Stream index of the most recent segment that arrived beyond the ackno, which the first SACK block reports
+    std::optional<uint64_t> _latest_out_of_order{};
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity) {}
+    //! \param storage how the inbound stream holds bytes (see TCPConfig::recv_storage)
+    TCPReceiver(const size_t capacity, const ByteStream::Storage storage = ByteStream::Storage::Ring)
+        : _reassembler(capacity, StreamReassembler::Engine::Intervals, storage), _capacity(capacity) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -53,11 +62,27 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief The window size as it goes in a header's `win` field: scaled down, and capped at 16 bits
+    //! \note The window in a SYN segment is never scaled (RFC 7323)
+    uint16_t advertised_window(const bool syn = false) const;
+
+    //! \brief SACK blocks ([RFC 2018](https://tools.ietf.org/html/rfc2018)) for the bytes held beyond the ackno
+    //! \returns at most `max_blocks` blocks, the one holding the most recent arrival first
+    std::vector<TCPOptions::SackBlock> sack_blocks(const size_t max_blocks) const;
     //!@}
 
+    //! \brief Scale the advertised window down by `shift` bits, as negotiated with the peer
+    void set_window_shift(const uint8_t shift) { _window_shift = shift; }
+
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
+    //! \brief Bound the memory held for out-of-order bytes (see StreamReassembler::set_memory_budget)
+    void set_memory_budget(const size_t budget, const StreamReassembler::Eviction eviction) {
+        _reassembler.set_memory_budget(budget, eviction);
+    }
+
     //! \brief handle an inbound segment
     void segment_received(const TCPSegment &seg);
 
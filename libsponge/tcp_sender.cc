@@ -1,8 +1,11 @@
 #include "tcp_sender.hh"
 
 #include "tcp_config.hh"
+#include "util.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <random>
 // Dummy implementation of a TCP sender
 
@@ -20,16 +23,104 @@ using namespace std;
 TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
+    , _rtt(retx_timeout, TCPConfig::MIN_RTO_DFLT, TCPConfig::MAX_RTO_DFLT)
     , _stream(capacity) {
     _current_retransmission_timeout = _initial_retransmission_timeout;
 }
 
+void RTTEstimator::sample(const uint64_t rtt_ms) {
+    const uint64_t rtt = rtt_ms * 8;
+    if (_samples == 0) {
+        _srtt = rtt;
+        _rttvar = rtt / 2;
+    } else {
+        const uint64_t error = rtt > _srtt ? rtt - _srtt : _srtt - rtt;
+        _rttvar = (3 * _rttvar + error) / 4;
+        _srtt = (7 * _srtt + rtt) / 8;
+    }
+    _samples++;
+}
+
+uint64_t RTTEstimator::rto() const {
+    if (_samples == 0) {
+        return _initial_rto;
+    }
+    // the clock granularity G is one millisecond
+    const uint64_t rto = (_srtt + max<uint64_t>(8, 4 * _rttvar) + 7) / 8;
+    return min(max(rto, _min_rto), _max_rto);
+}
+
+RTTEstimator::Stats RTTEstimator::stats() const {
+    Stats stats;
+    stats.srtt = _srtt / 8;
+    stats.rttvar = _rttvar / 8;
+    stats.rto = rto();
+    stats.samples = _samples;
+    return stats;
+}
+
+//! \details The current timeout is left alone until the next ack of new data.
+void TCPSender::set_adaptive_rto(const uint64_t min_rto, const uint64_t max_rto) {
+    _rtt = RTTEstimator{_initial_retransmission_timeout, min_rto, max_rto};
+    _adaptive_rto = true;
+}
+
+void TCPSender::set_max_payload_size(const size_t size) {
+    _max_payload_size = size;
+    if (not _congestion_control) {
+        return;
+    }
+    if (_next_seqno <= 1) {
+        // the initial window (RFC 6928) depends on the MSS, which the peer's SYN may only now have settled
+        _congestion_control = CongestionControl::make(_congestion_algorithm, size);
+    } else {
+        _congestion_control->set_mss(size);
+    }
+}
+
+void TCPSender::set_congestion_control(const CongestionControl::Algorithm algorithm) {
+    _congestion_algorithm = algorithm;
+    _congestion_control = CongestionControl::make(algorithm, _max_payload_size);
+}
+
 uint64_t TCPSender::bytes_in_flight() const { return _outstanding_bytes; }
 
-//! \details set the segment header and payload, fill the other side receive window size as much as possible
+//! \details In recovery with SACK information, RFC 6675's estimate: SACKed segments have left the network,
+//! and so have the holes below the highest SACKed byte, unless this recovery has resent them.
+size_t TCPSender::pipe() const {
+    if (not in_recovery() or _outstanding_segments.empty() or
+        _highest_sacked <= _outstanding_segments.front().seqno) {
+        return _outstanding_bytes;
+    }
+    size_t pipe = 0;
+    for (const auto &outstanding : _outstanding_segments) {
+        const bool resent = outstanding.seqno < _retransmitted_up_to;
+        const bool lost = outstanding.seqno < _highest_sacked and not resent;
+        if (not outstanding.sacked and not lost) {
+            pipe += outstanding.segment.length_in_sequence_space();
+        }
+    }
+    return pipe;
+}
+
+size_t TCPSender::congestion_room() const {
+    if (not _congestion_control) {
+        return numeric_limits<size_t>::max();
+    }
+    const size_t window = _congestion_control->window();
+    const size_t in_flight = pipe();
+    return window > in_flight ? window - in_flight : 0;
+}
+
+//! \details set the segment header and payload, fill the other side receive window size as much as possible,
+//! in segments of up to the max payload size; with Nagle's algorithm on, a smaller segment (the tail of the
+//! stream, or a sliver of window) goes out only when nothing is in flight (RFC 896, RFC 1122 section 4.2.3.4)
 void TCPSender::fill_window() {
-    size_t receiver_win_size = _win_size ? _win_size : 1;
-    while ((receiver_win_size > _outstanding_bytes) && !_fin_sent) {
+    const size_t receiver_win_size = _win_size ? _win_size : 1;
+    // the room left in the peer's window, which the congestion window (when there is one) limits further
+    size_t room = receiver_win_size > _outstanding_bytes ? receiver_win_size - _outstanding_bytes : 0;
+    room = min(room, congestion_room());
+    while (room > 0 && !_fin_sent) {
         TCPSegment seg;
         if (!_syn_sent) {
             seg.header().syn = true;
@@ -38,19 +129,29 @@ void TCPSender::fill_window() {
         seg.header().seqno = next_seqno();
 
         // the max bytes could this segment carried
-        size_t max_payload_size =
-            min(TCPConfig::MAX_PAYLOAD_SIZE, receiver_win_size - _outstanding_bytes - seg.header().syn);
-        string payload = _stream.read(max_payload_size);
-        seg.payload() = Buffer(std::move(payload));
+        size_t max_payload_size = min(_max_payload_size, room - seg.header().syn);
+        // Nagle: while data is unacknowledged, hold back anything short of a full segment, unless it ends the stream
+        const size_t buffered = _stream.buffer_size();
+        const bool ends_stream = _stream.input_ended() and buffered <= max_payload_size;
+        if (_nagle and _outstanding_bytes > 0 and min(buffered, max_payload_size) < _max_payload_size and
+            not ends_stream) {
+            break;
+        }
+        // sum the payload while copying it out of the stream, so serializing the segment won't have to
+        InternetChecksum payload_check;
+        Buffer payload = _stream.peek_summed(max_payload_size, payload_check);
+        seg.set_payload(move(payload), payload_check.sum());
+        _stream.pop_output(seg.payload().size());
         size_t seg_length = seg.length_in_sequence_space();
         // send FIN flag if reached EOF of stream
-        if (!_fin_sent && _stream.eof() && seg_length + _outstanding_bytes < receiver_win_size) {
+        if (!_fin_sent && _stream.eof() && seg_length < room) {
             seg.header().fin = true;
             _fin_sent = true;
             seg_length++;
         }
         if (seg_length) {
             send_segment(seg);
+            room -= seg_length;
         } else {
             break;
         }
@@ -59,8 +160,12 @@ void TCPSender::fill_window() {
 //! The segment here is NOT EMPTY (non zero length in sequence space)
 void TCPSender::send_segment(TCPSegment &seg) {
     _segments_out.push(seg);
-    _outstanding_segments.emplace_back(_next_seqno, seg);
+    _outstanding_segments.push_back({_next_seqno, seg, _clock_ms});
     const auto seg_length = seg.length_in_sequence_space();
+    if (not _timed_seqno_end.has_value()) {
+        _timed_seqno_end = _next_seqno + seg_length;
+        _timed_sent_at = _clock_ms;
+    }
     _next_seqno += seg_length;
     _outstanding_bytes += seg_length;
 
@@ -69,26 +174,89 @@ void TCPSender::send_segment(TCPSegment &seg) {
     }
 }
 
+void TCPSender::retransmit_earliest() {
+    _segments_out.push(_outstanding_segments.front().segment);
+    // the ack for a retransmitted segment can't tell which transmission it answers
+    _timed_seqno_end.reset();
+}
+
+//! \details Without SACK, only the earliest segment is known to be missing (and only in fast recovery: after
+//! a timeout, the ack that follows says nothing about it). With SACK, so is every segment that hasn't been
+//! SACKed but lies below one that has; those are resent as the congestion window allows.
+void TCPSender::retransmit_lost() {
+    for (const auto &outstanding : _outstanding_segments) {
+        const bool earliest = &outstanding == &_outstanding_segments.front() and not _recovery_after_timeout;
+        if (not earliest and (outstanding.seqno >= _highest_sacked or congestion_room() == 0)) {
+            break;
+        }
+        if (outstanding.sacked or outstanding.seqno < _retransmitted_up_to) {
+            continue;
+        }
+        _segments_out.push(outstanding.segment);
+        _retransmitted_up_to = outstanding.seqno + outstanding.segment.length_in_sequence_space();
+        _timed_seqno_end.reset();
+    }
+}
+
+//! \details Blocks outside the outstanding sequence space are ignored.
+void TCPSender::sack_received(const vector<TCPOptions::SackBlock> &blocks) {
+    for (const auto &block : blocks) {
+        const uint64_t left = unwrap(block.left, _isn, _next_seqno);
+        const uint64_t right = unwrap(block.right, _isn, _next_seqno);
+        if (left >= right or right > _next_seqno) {
+            continue;
+        }
+        _highest_sacked = max(_highest_sacked, right);
+        for (auto &outstanding : _outstanding_segments) {
+            if (outstanding.seqno >= right) {
+                break;
+            }
+            if (outstanding.seqno >= left and
+                outstanding.seqno + outstanding.segment.length_in_sequence_space() <= right) {
+                outstanding.sacked = true;
+            }
+        }
+    }
+}
+
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param echoed_timestamp The timestamp the receiver echoed, if any
+//! \param carries_data Whether the ack arrived on a segment with data, SYN or FIN
+//! \details A round trip is measured from the echoed timestamp if there is one, and otherwise from the
+//! timed segment, provided it wasn't retransmitted (Karn's algorithm). An echoed timestamp from the future,
+//! or from before the earliest segment this ack covers was first sent, is not a round trip and is ignored.
+//!
+//! The DUP_ACK_THRESHOLD-th duplicate ack in a row retransmits the earliest outstanding segment and starts
+//! fast recovery, which lasts until everything sent before it is acked (or, for Reno, until the next new ack).
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const size_t window_size,
+                             const optional<uint32_t> echoed_timestamp,
+                             const bool carries_data) {
     //! `absolute_ackno` is the number of bytes that the receiver received.
     //! `_next_seqno` is the number of bytes that the sender wants to send, i.e. the last `absolute-seqno`
     size_t absolute_ackno = unwrap(ackno, _isn, _next_seqno);
     if (absolute_ackno > _next_seqno) {
         return;
     }
+    // a duplicate ack (RFC 5681) acks nothing new, updates nothing, and carries nothing else
+    const bool duplicate = _fast_retransmit and not carries_data and not _outstanding_segments.empty() and
+                           absolute_ackno == _outstanding_segments.front().seqno and window_size == _win_size;
     _win_size = window_size;
+    // an echoed timestamp can't be older than the first transmission of what the ack covers
+    const uint64_t earliest_sent_ms = _outstanding_segments.empty() ? _clock_ms : _outstanding_segments.front().sent_ms;
     //! Remove segments that have now been fully acknoledged segment in `_outstanding_segment`
     auto iter = _outstanding_segments.begin();
     bool acked_new_data = false;
+    size_t acked_bytes = 0;
     while (!_outstanding_segments.empty()) {
-        const auto &seg = iter->second;
+        const auto &seg = iter->segment;
         const auto seg_length = seg.length_in_sequence_space();
-        if (iter->first + seg_length <= absolute_ackno) {
+        if (iter->seqno + seg_length <= absolute_ackno) {
             // erase returns the iterator following the last removed element.
             iter = _outstanding_segments.erase(iter);
             _outstanding_bytes -= seg_length;
+            acked_bytes += seg_length;
             acked_new_data = true;
         } else {
             break;
@@ -98,13 +266,74 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     //! the retransmission timer will restart if there are outstanding segments (for the current value of RTO).,
     //! otherwise the timer will stop
     if (acked_new_data) {
-        _current_retransmission_timeout = _initial_retransmission_timeout;
+        const bool timed_segment_acked = _timed_seqno_end.has_value() and absolute_ackno >= _timed_seqno_end.value();
+        if (echoed_timestamp.has_value()) {
+            // compared with wraparound, like sequence numbers
+            const auto elapsed = static_cast<int32_t>(static_cast<uint32_t>(_clock_ms) - echoed_timestamp.value());
+            if (elapsed >= 0 and static_cast<uint64_t>(elapsed) <= _clock_ms - earliest_sent_ms) {
+                _rtt.sample(elapsed);
+            }
+        } else if (timed_segment_acked) {
+            _rtt.sample(_clock_ms - _timed_sent_at);
+        }
+        if (timed_segment_acked) {
+            _timed_seqno_end.reset();
+        }
+        _current_retransmission_timeout = _adaptive_rto ? _rtt.rto() : _initial_retransmission_timeout;
+        _duplicate_acks = 0;
+        if (not _recovery_point.has_value()) {
+            if (_congestion_control) {
+                _congestion_control->on_ack(acked_bytes, _clock_ms, _rtt.stats().srtt);
+            }
+        } else if (_recovery_after_timeout) {
+            // slow start goes on, resending what the timeout left missing as the window opens
+            if (_congestion_control) {
+                _congestion_control->on_ack(acked_bytes, _clock_ms, _rtt.stats().srtt);
+            }
+            if (absolute_ackno >= _recovery_point.value()) {
+                _recovery_point.reset();
+            } else {
+                retransmit_lost();
+            }
+        } else if (absolute_ackno >= _recovery_point.value() or
+                   (_congestion_control and not _congestion_control->recovers_from_partial_acks() and
+                    not _recovery_uses_sack)) {
+            _recovery_point.reset();
+            if (_congestion_control) {
+                _congestion_control->on_recovery_end();
+            }
+        } else {
+            // a partial ack: the segment at the new ackno was lost as well
+            if (_congestion_control and not _recovery_uses_sack) {
+                _congestion_control->on_partial_ack(acked_bytes);
+            }
+            retransmit_lost();
+        }
         if (!_outstanding_segments.empty()) {
             _retrans_timer.start_new_timer(_current_retransmission_timeout);
         } else {
             _retrans_timer.stop_retrans_timer();
         }
         _consecutive_retransmission_cnt = 0;
+    } else if (duplicate) {
+        _duplicate_acks++;
+        if (_recovery_point.has_value()) {
+            // with SACK, pipe() already counts the segments that left the network
+            if (_congestion_control and not _recovery_uses_sack and not _recovery_after_timeout) {
+                _congestion_control->on_duplicate_ack();
+            }
+            // new SACK blocks may have shown more holes
+            retransmit_lost();
+        } else if (_duplicate_acks == TCPConfig::DUP_ACK_THRESHOLD) {
+            _recovery_point = _next_seqno;
+            _recovery_after_timeout = false;
+            _retransmitted_up_to = 0;
+            _recovery_uses_sack = _highest_sacked > absolute_ackno;
+            if (_congestion_control) {
+                _congestion_control->on_fast_retransmit(_outstanding_bytes);
+            }
+            retransmit_lost();
+        }
     }
     fill_window();
     return;
@@ -112,17 +341,41 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
+    _clock_ms += ms_since_last_tick;
     _retrans_timer.tick_to_retrans_timer(ms_since_last_tick);
     // If the retrans_timer is expired, it will retransmit the earliest segment when the window size is not zero
     // then double the RTO, restart a new timer.
     if (_retrans_timer.is_expired() && !_outstanding_segments.empty()) {
-        auto iter = _outstanding_segments.begin();
         if (_win_size > 0) {
+            // a timeout with the window open is taken as a sign of congestion (once, not per backoff)
+            if (_congestion_control and _consecutive_retransmission_cnt == 0) {
+                _congestion_control->on_timeout(_outstanding_bytes);
+            }
             _current_retransmission_timeout <<= 1;
+            if (_adaptive_rto) {
+                _current_retransmission_timeout = min(_current_retransmission_timeout, _rtt.max_rto());
+            }
             _consecutive_retransmission_cnt++;
+            // a timeout ends fast recovery, and slow start takes over; with loss recovery on, the acks that
+            // follow resend the rest of what the timeout left missing (RFC 6582 section 3.2, step 4)
+            _recovery_point.reset();
+            _duplicate_acks = 0;
+            if (_fast_retransmit) {
+                _recovery_point = _next_seqno;
+                _recovery_after_timeout = true;
+                const auto &earliest = _outstanding_segments.front();
+                _retransmitted_up_to = earliest.seqno + earliest.segment.length_in_sequence_space();
+            }
+            // and the peer may have discarded what it SACKed (RFC 2018 section 8)
+            for (auto &outstanding : _outstanding_segments) {
+                outstanding.sacked = false;
+            }
+            _highest_sacked = 0;
         }
         if (_consecutive_retransmission_cnt <= TCPConfig::MAX_RETX_ATTEMPTS) {
-            _segments_out.push(iter->second);
+            retransmit_earliest();
+        } else {
+            _timed_seqno_end.reset();
         }
         _retrans_timer.start_new_timer(_current_retransmission_timeout);
     }
@@ -2,11 +2,14 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
 #include <functional>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <vector>
 
@@ -46,6 +49,45 @@ class RetransTimer {
     }
 };
 
+//! \brief Round-trip time estimates, and the retransmission timeout they imply ([RFC 6298](\ref rfc::rfc6298))
+class RTTEstimator {
+  private:
+    //! \name Estimates in eighths of a millisecond, so the RFC's 1/8 and 1/4 gains don't lose precision
+    //!@{
+    uint64_t _srtt{0};
+    uint64_t _rttvar{0};
+    //!@}
+    uint64_t _samples{0};
+    uint64_t _initial_rto;
+    uint64_t _min_rto;
+    uint64_t _max_rto;
+
+  public:
+    //! \brief Estimates in milliseconds
+    struct Stats {
+        uint64_t srtt{0};     //!< smoothed round-trip time (zero until the first sample)
+        uint64_t rttvar{0};   //!< round-trip time variation
+        uint64_t rto{0};      //!< retransmission timeout, before any backoff
+        uint64_t samples{0};  //!< number of round-trip times measured
+    };
+
+    //! \param[in] initial_rto the timeout to use until the first sample
+    //! \param[in] min_rto,max_rto bounds on the timeout computed from samples
+    RTTEstimator(const uint64_t initial_rto, const uint64_t min_rto, const uint64_t max_rto)
+        : _initial_rto(initial_rto), _min_rto(min_rto), _max_rto(max_rto) {}
+
+    //! \brief Take a round-trip time measurement into account
+    void sample(const uint64_t rtt_ms);
+
+    //! \brief The retransmission timeout: SRTT + 4 * RTTVAR, within the bounds (the initial one until a sample)
+    uint64_t rto() const;
+
+    //! \brief The largest timeout, which backoff doesn't go past either
+    uint64_t max_rto() const { return _max_rto; }
+
+    Stats stats() const;
+};
+
 //! \brief The "sender" part of a TCP implementation.
 
 //! Accepts a ByteStream, divides it up into segments and sends the
@@ -58,17 +100,29 @@ class TCPSender {
     bool _syn_sent{false};
     //! When FIN is sent, it means that the data stream is closed on its own side, `fill_window` will return directly
     bool _fin_sent{false};
-    //! the receive windows size, from the other side
-    uint16_t _win_size{1};
+    //! the receive windows size, from the other side (in bytes, already scaled)
+    size_t _win_size{1};
+    //! the most payload one segment may carry (see set_max_payload_size)
+    size_t _max_payload_size{TCPConfig::MAX_PAYLOAD_SIZE};
 
     //! Once the segment is filled the window(using the data payload), it will be sent to the other side
     //! In this lab `send_segments` means move the segment to `_segments_out` FIFO and `_outstanding_segments` map
     void send_segment(TCPSegment &seg);
+    //! Send the earliest outstanding segment again
+    void retransmit_earliest();
+    //! In fast recovery, send the earliest outstanding segment and every hole the SACK scoreboard shows again,
+    //! skipping what this recovery has already resent
+    void retransmit_lost();
     //! keep track of segments which have been sent but not yet acked by the receiver
     //!@{
-    // first-> the absolute sequence number, it will be mono increased
-    // second-> the outstanding tcp segment
-    std::vector<std::pair<size_t, TCPSegment>> _outstanding_segments{};
+    //! A segment in flight, and whether the peer's SACK blocks say it arrived
+    struct OutstandingSegment {
+        size_t seqno;        //!< the absolute sequence number, it will be mono increased
+        TCPSegment segment;  //!< the outstanding tcp segment
+        uint64_t sent_ms;    //!< `_clock_ms` when it was first sent
+        bool sacked{false};  //!< the peer holds the whole segment, though the ackno hasn't reached it
+    };
+    std::vector<OutstandingSegment> _outstanding_segments{};
     size_t _outstanding_bytes{0};
     // !@}
 
@@ -85,6 +139,40 @@ class TCPSender {
     uint64_t _current_retransmission_timeout{0};
     unsigned int _consecutive_retransmission_cnt{0};
 
+    //! round-trip time estimates, kept whether or not they drive the RTO
+    RTTEstimator _rtt;
+    //! when set, a new ack sets the RTO from `_rtt` instead of back to `_initial_retransmission_timeout`
+    bool _adaptive_rto{false};
+    //! milliseconds of ticks so far
+    uint64_t _clock_ms{0};
+
+    //! the congestion window, if a congestion control algorithm is in use
+    std::unique_ptr<CongestionControl> _congestion_control{};
+    //! the algorithm behind `_congestion_control` (see set_congestion_control)
+    CongestionControl::Algorithm _congestion_algorithm{CongestionControl::Algorithm::None};
+    //! \name Fast retransmit and fast recovery
+    //!@{
+    bool _fast_retransmit{false};               //!< see set_fast_retransmit
+    unsigned int _duplicate_acks{0};            //!< duplicate acks in a row
+    std::optional<uint64_t> _recovery_point{};  //!< during recovery, the absolute seqno whose ack ends it
+    uint64_t _retransmitted_up_to{0};           //!< during recovery, holes before this have been resent
+    uint64_t _highest_sacked{0};                //!< absolute seqno just past the highest SACKed byte
+    bool _recovery_uses_sack{false};            //!< the recovery began with SACK information, so pipe() paces it
+    bool _recovery_after_timeout{false};        //!< the recovery began with a timeout, not duplicate acks
+    //!@}
+    //! hold back segments smaller than the max payload size while data is in flight (see set_nagle)
+    bool _nagle{false};
+
+    //! Bytes (in sequence space) estimated to be in the network, for comparison with the congestion window
+    size_t pipe() const;
+    //! How many more bytes the congestion window allows in flight (unlimited without congestion control)
+    size_t congestion_room() const;
+    //! \name One segment at a time is timed; the ack that covers it completes a round trip
+    //!@{
+    std::optional<uint64_t> _timed_seqno_end{};  //!< absolute seqno just past the timed segment
+    uint64_t _timed_sent_at{0};                  //!< `_clock_ms` when it was sent
+    //!@}
+
     //! outgoing stream of bytes that have not yet been sent
     ByteStream _stream;
 
@@ -107,7 +195,18 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param window_size the peer's window in bytes, after any window scaling
+    //! \param echoed_timestamp the TSecr of the ack, if timestamps are in use (a clock_ms() value we sent)
+    //! \param carries_data whether the ack came on a segment that occupies sequence space (so it can't be a
+    //! duplicate ack)
+    void ack_received(const WrappingInt32 ackno,
+                      const size_t window_size,
+                      const std::optional<uint32_t> echoed_timestamp = {},
+                      const bool carries_data = false);
+
+    //! \brief SACK blocks arrived ([RFC 2018](https://tools.ietf.org/html/rfc2018)); call before ack_received()
+    //! \details Marks the outstanding segments the blocks cover, so fast recovery resends only the others.
+    void sack_received(const std::vector<TCPOptions::SackBlock> &blocks);
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -119,6 +218,27 @@ class TCPSender {
     void tick(const size_t ms_since_last_tick);
     //!@}
 
+    //! \brief Limit each segment's payload to `size` bytes (e.g. to the MSS negotiated with the peer)
+    //! \details If only the SYN has been sent, the congestion window starts over at the initial window for
+    //! `size`-byte segments.
+    void set_max_payload_size(const size_t size);
+
+    //! \brief Set the RTO from measured round-trip times, within `[min_rto, max_rto]` milliseconds
+    void set_adaptive_rto(const uint64_t min_rto, const uint64_t max_rto);
+
+    //! \brief Limit the bytes in flight with a congestion window, managed by `algorithm`
+    void set_congestion_control(const CongestionControl::Algorithm algorithm);
+
+    //! \brief Recover from losses without waiting for the timer: retransmit on duplicate acks, and after a
+    //! timeout resend further holes as acks arrive (off by default: the lab tests expect only timer
+    //! retransmissions)
+    void set_fast_retransmit(const bool enabled) { _fast_retransmit = enabled; }
+
+    //! \brief Coalesce small writes with Nagle's algorithm ([RFC 896](https://tools.ietf.org/html/rfc896)):
+    //! while data is in flight, send only full segments (off by default: the lab tests expect every write to
+    //! go out at once)
+    void set_nagle(const bool enabled) { _nagle = enabled; }
+
     //! \name Accessors
     //!@{
 
@@ -130,6 +250,18 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Round-trip time estimates
+    RTTEstimator::Stats rtt_stats() const { return _rtt.stats(); }
+
+    //! \brief Is the sender recovering from a loss (in fast recovery, or resending holes after a timeout)?
+    bool in_recovery() const { return _recovery_point.has_value(); }
+
+    //! \brief The congestion control algorithm in use, if any
+    const CongestionControl *congestion_control() const { return _congestion_control.get(); }
+
+    //! \brief Milliseconds the sender has been ticked for (the clock its round-trip times are measured on)
+    uint64_t clock_ms() const { return _clock_ms; }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
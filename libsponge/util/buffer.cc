@@ -2,20 +2,140 @@
 
 using namespace std;
 
+//! Set once this thread's FreeLists has been destroyed, so that Buffers released later fall back to the heap
+static thread_local bool free_lists_destroyed = false;
+
+//! \brief The free lists behind BufferPool (one set per thread, so no locking is needed)
+struct FreeLists {
+    vector<string> chunks{};
+    vector<void *> blocks{};
+
+    FreeLists() {
+        chunks.reserve(BufferPool::MAX_FREE);
+        blocks.reserve(BufferPool::MAX_FREE);
+    }
+
+    ~FreeLists() {
+        free_lists_destroyed = true;
+        for (void *block : blocks) {
+            ::operator delete(block);
+        }
+    }
+
+    FreeLists(const FreeLists &other) = delete;
+    FreeLists &operator=(const FreeLists &other) = delete;
+};
+
+//! \returns this thread's free lists, or `nullptr` during thread exit
+static FreeLists *free_lists() {
+    if (free_lists_destroyed) {
+        return nullptr;
+    }
+    thread_local FreeLists lists;
+    return &lists;
+}
+
+string BufferPool::take() {
+    FreeLists *lists = free_lists();
+    if (lists and not lists->chunks.empty()) {
+        string chunk = move(lists->chunks.back());
+        lists->chunks.pop_back();
+        return chunk;
+    }
+    string chunk;
+    chunk.reserve(CHUNK_SIZE);
+    return chunk;
+}
+
+//! \details Strings with less than CHUNK_SIZE reserved are too small to hand out again, and
+//! strings with twice that or more would hoard memory; both are simply freed.
+void BufferPool::recycle(string &&str) noexcept {
+    if (str.capacity() < CHUNK_SIZE or str.capacity() >= 2 * CHUNK_SIZE) {
+        return;
+    }
+    FreeLists *lists = free_lists();
+    if (lists and lists->chunks.size() < MAX_FREE) {
+        str.clear();
+        lists->chunks.push_back(move(str));
+    }
+}
+
+void *BufferPool::allocate_block(const size_t size) {
+    if (size > BLOCK_SIZE) {
+        return ::operator new(size);
+    }
+    FreeLists *lists = free_lists();
+    if (lists and not lists->blocks.empty()) {
+        void *block = lists->blocks.back();
+        lists->blocks.pop_back();
+        return block;
+    }
+    return ::operator new(BLOCK_SIZE);
+}
+
+void BufferPool::deallocate_block(void *block, const size_t size) noexcept {
+    if (size <= BLOCK_SIZE) {
+        FreeLists *lists = free_lists();
+        if (lists and lists->blocks.size() < MAX_FREE) {
+            lists->blocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
+
 void Buffer::remove_prefix(const size_t n) {
     if (n > str().size()) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    _size -= n;
+    if (_storage and _size == 0) {
+        _storage.reset();
+        _starting_offset = 0;
+    }
+}
+
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _size -= n;
+    if (_storage and _size == 0) {
         _storage.reset();
+        _starting_offset = 0;
+    }
+}
+
+//! \details The storage comes from BufferPool, and the headroom is zeroed so that any header options
+//! a layer leaves alone go out as zeros.
+PacketBuilder::PacketBuilder(const string_view payload, const size_t headroom)
+    : _storage(BufferPool::take()), _start(headroom) {
+    _storage.resize(headroom);
+    _storage.append(payload);
+}
+
+char *PacketBuilder::prepend(const size_t n) {
+    if (n > _start) {
+        throw length_error("PacketBuilder::prepend: out of headroom");
     }
+    _start -= n;
+    return _storage.data() + _start;
+}
+
+Buffer PacketBuilder::finish() {
+    Buffer ret{move(_storage)};
+    ret.remove_prefix(_start);
+    _storage.clear();
+    _start = 0;
+    return ret;
 }
 
 void BufferList::append(const BufferList &other) {
     for (const auto &buf : other._buffers) {
         _buffers.push_back(buf);
     }
+    _size += other._size;
 }
 
 BufferList::operator Buffer() const {
@@ -32,28 +152,22 @@ BufferList::operator Buffer() const {
 }
 
 string BufferList::concatenate() const {
-    std::string ret;
-    ret.reserve(size());
+    const size_t total_size = size();
+    std::string ret = total_size <= BufferPool::CHUNK_SIZE ? BufferPool::take() : std::string();
+    ret.reserve(total_size);
     for (const auto &buf : _buffers) {
         ret.append(buf);
     }
     return ret;
 }
 
-size_t BufferList::size() const {
-    size_t ret = 0;
-    for (const auto &buf : _buffers) {
-        ret += buf.size();
+void BufferList::remove_prefix(size_t n) {
+    if (n > _size) {
+        throw std::out_of_range("BufferList::remove_prefix");
     }
-    return ret;
-}
+    _size -= n;
 
-void BufferList::remove_prefix(size_t n) {
     while (n > 0) {
-        if (_buffers.empty()) {
-            throw std::out_of_range("BufferList::remove_prefix");
-        }
-
         if (n < _buffers.front().str().size()) {
             _buffers.front().remove_prefix(n);
             n = 0;
@@ -66,39 +180,27 @@ void BufferList::remove_prefix(size_t n) {
 
 BufferViewList::BufferViewList(const BufferList &buffers) {
     for (const auto &x : buffers.buffers()) {
-        _views.push_back(x);
+        append(x);
     }
 }
 
 void BufferViewList::remove_prefix(size_t n) {
-    while (n > 0) {
-        if (_views.empty()) {
-            throw std::out_of_range("BufferListView::remove_prefix");
-        }
+    if (n > _size) {
+        throw std::out_of_range("BufferListView::remove_prefix");
+    }
+    _size -= n;
 
-        if (n < _views.front().size()) {
-            _views.front().remove_prefix(n);
+    while (n > 0) {
+        iovec &front = _views.front();
+        if (n < front.iov_len) {
+            front.iov_base = static_cast<char *>(front.iov_base) + n;
+            front.iov_len -= n;
             n = 0;
         } else {
-            n -= _views.front().size();
+            n -= front.iov_len;
             _views.pop_front();
         }
     }
 }
 
-size_t BufferViewList::size() const {
-    size_t ret = 0;
-    for (const auto &buf : _views) {
-        ret += buf.size();
-    }
-    return ret;
-}
-
-vector<iovec> BufferViewList::as_iovecs() const {
-    vector<iovec> ret;
-    ret.reserve(_views.size());
-    for (const auto &x : _views) {
-        ret.push_back({const_cast<char *>(x.data()), x.size()});
-    }
-    return ret;
-}
+vector<iovec> BufferViewList::as_iovecs() const { return {_views.begin(), _views.end()}; }
@@ -2,7 +2,8 @@
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
 #include <algorithm>
-#include <deque>
+#include <array>
+#include <iterator>
 #include <memory>
 #include <numeric>
 #include <stdexcept>
@@ -11,17 +12,73 @@
 #include <sys/uio.h>
 #include <vector>
 
-//! \brief A reference-counted read-only string that can discard bytes from the front
+//! \brief Per-thread free lists that recycle the memory behind Buffers
+class BufferPool {
+  public:
+    static constexpr size_t CHUNK_SIZE = 2048;  //!< Bytes reserved in each pooled string (one MTU-sized packet)
+    static constexpr size_t BLOCK_SIZE = 64;    //!< Size of each pooled block (holds a Buffer's refcount and string)
+    static constexpr size_t MAX_FREE = 1024;    //!< Most chunks, and most blocks, that each thread keeps
+
+    //! \returns an empty string with CHUNK_SIZE bytes reserved, recycled from this thread's free list if possible
+    static std::string take();
+
+    //! Keep the storage of `str` for a later take(), if it is chunk-sized and the free list has room
+    static void recycle(std::string &&str) noexcept;
+
+    //! \name Fixed-size blocks (requests larger than BLOCK_SIZE go straight to the heap)
+    //!@{
+    static void *allocate_block(const size_t size);
+    static void deallocate_block(void *block, const size_t size) noexcept;
+    //!@}
+
+    //! \brief An allocator for std::allocate_shared that draws from the block free list
+    template <typename T>
+    struct Allocator {
+        using value_type = T;
+
+        Allocator() = default;
+        template <typename U>
+        Allocator(const Allocator<U> & /* other */) noexcept {}
+
+        T *allocate(const size_t n) { return static_cast<T *>(allocate_block(n * sizeof(T))); }
+        void deallocate(T *p, const size_t n) noexcept { deallocate_block(p, n * sizeof(T)); }
+
+        template <typename U>
+        bool operator==(const Allocator<U> & /* other */) const noexcept {
+            return true;
+        }
+        template <typename U>
+        bool operator!=(const Allocator<U> & /* other */) const noexcept {
+            return false;
+        }
+    };
+};
+
+//! \brief A reference-counted read-only string that can discard bytes from the front or back
 class Buffer {
   private:
-    std::shared_ptr<std::string> _storage{};
+    //! \brief The shared string, which goes back to BufferPool when the last Buffer referring to it is gone
+    struct Storage {
+        std::string str;
+
+        explicit Storage(std::string &&s) noexcept : str(std::move(s)) {}
+        ~Storage() { BufferPool::recycle(std::move(str)); }
+        Storage(const Storage &other) = delete;
+        Storage &operator=(const Storage &other) = delete;
+    };
+
+    std::shared_ptr<Storage> _storage{};
     size_t _starting_offset{};
+    size_t _size{};  //!< Number of bytes visible after `_starting_offset`
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    //! \note Strings from BufferPool::take() are handed back to the pool once every copy is gone
+    Buffer(std::string &&str) noexcept
+        : _storage(std::allocate_shared<Storage>(BufferPool::Allocator<Storage>(), std::move(str)))
+        , _size(_storage->str.size()) {}
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -29,7 +86,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->str.data() + _starting_offset, _size};
     }
 
     operator std::string_view() const { return str(); }
@@ -47,6 +104,114 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Other copies of the Buffer still see the discarded bytes.
+    void remove_suffix(const size_t n);
+};
+
+//! \brief Builds a serialized packet back to front in one contiguous string
+//! \details The payload is copied in once, after some headroom, and each protocol layer then
+//! writes its header in place just before the bytes already there. The finished packet is a
+//! single Buffer, so it takes one (usually pooled) allocation and goes out in one write().
+class PacketBuilder {
+  private:
+    std::string _storage;
+    size_t _start;  //!< Offset in `_storage` of the packet's first byte
+
+  public:
+    //! Room for an IPv4 header and a TCP header, each with the most options they can carry
+    static constexpr size_t DEFAULT_HEADROOM = 128;
+
+    //! \brief Start a packet holding a copy of `payload`, with `headroom` bytes free in front of it
+    explicit PacketBuilder(const std::string_view payload, const size_t headroom = DEFAULT_HEADROOM);
+
+    //! \brief Grow the packet by `n` bytes at the front
+    //! \returns where the caller writes those bytes
+    //! \throws std::length_error if the headroom is used up
+    char *prepend(const size_t n);
+
+    //! \brief The packet as built so far
+    std::string_view str() const { return {_storage.data() + _start, _storage.size() - _start}; }
+
+    //! \brief Size of the packet as built so far
+    size_t size() const { return _storage.size() - _start; }
+
+    //! \brief Hand the packet over as a Buffer, leaving the builder empty
+    Buffer finish();
+};
+
+//! \brief A queue that keeps up to `N` elements inline, and only allocates once it holds more
+//! \details The live elements are always contiguous, so they can be handed to a system call as an array.
+template <typename T, size_t N>
+class InlineDeque {
+  private:
+    std::array<T, N> _inline{};
+    std::vector<T> _spilled{};  //!< Holds the elements instead of `_inline` once more than `N` were live
+    bool _is_spilled{false};
+    size_t _head{0};  //!< Index of the first live element
+    size_t _tail{0};  //!< Index one past the last live element
+
+    T *storage() { return _is_spilled ? _spilled.data() : _inline.data(); }
+    const T *storage() const { return _is_spilled ? _spilled.data() : _inline.data(); }
+
+  public:
+    //! \brief Add an element at the back
+    void push_back(T value) {
+        if (not _is_spilled) {
+            if (_tail == N and _head > 0) {
+                // slide the live elements to the front to make room
+                std::move(_inline.begin() + _head, _inline.end(), _inline.begin());
+                std::fill(_inline.end() - _head, _inline.end(), T{});
+                _tail -= _head;
+                _head = 0;
+            }
+            if (_tail < N) {
+                _inline[_tail++] = std::move(value);
+                return;
+            }
+            _spilled.reserve(2 * N);
+            std::move(_inline.begin(), _inline.end(), std::back_inserter(_spilled));
+            std::fill(_inline.begin(), _inline.end(), T{});
+            _is_spilled = true;
+        }
+        _spilled.push_back(std::move(value));
+        _tail = _spilled.size();
+    }
+
+    //! \brief Remove the front element
+    void pop_front() {
+        storage()[_head++] = T{};
+        if (_head == _tail) {
+            clear();
+        }
+    }
+
+    //! \brief Remove every element (and go back to inline storage)
+    void clear() {
+        if (_is_spilled) {
+            _spilled.clear();
+            _is_spilled = false;
+        } else {
+            std::fill(_inline.begin() + _head, _inline.begin() + _tail, T{});
+        }
+        _head = _tail = 0;
+    }
+
+    //! \name Element access
+    //!@{
+    size_t size() const { return _tail - _head; }
+    bool empty() const { return _head == _tail; }
+    T &front() { return storage()[_head]; }
+    const T &front() const { return storage()[_head]; }
+    T &operator[](const size_t i) { return storage()[_head + i]; }
+    const T &operator[](const size_t i) const { return storage()[_head + i]; }
+    const T *data() const { return storage() + _head; }
+    T *begin() { return storage() + _head; }
+    T *end() { return storage() + _tail; }
+    const T *begin() const { return storage() + _head; }
+    const T *end() const { return storage() + _tail; }
+    //!@}
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -55,8 +220,13 @@ class Buffer {
 //! encapsulate a TCP payload in a TCPSegment, and then encapsulate
 //! the TCPSegment in an IPv4Datagram) without copying the payload.
 class BufferList {
+  public:
+    //! Most packets are an IP header, a TCP header and a payload, so four pieces stay inline
+    using Pieces = InlineDeque<Buffer, 4>;
+
   private:
-    std::deque<Buffer> _buffers{};
+    Pieces _buffers{};
+    size_t _size{0};  //!< Total bytes in `_buffers`
 
   public:
     //! \name Constructors
@@ -65,7 +235,7 @@ class BufferList {
     BufferList() = default;
 
     //! \brief Construct from a Buffer
-    BufferList(Buffer buffer) : _buffers{buffer} {}
+    BufferList(Buffer buffer) : _size(buffer.size()) { _buffers.push_back(std::move(buffer)); }
 
     //! \brief Construct by taking ownership of a std::string
     BufferList(std::string &&str) noexcept {
@@ -75,7 +245,7 @@ class BufferList {
     //!@}
 
     //! \brief Access the underlying queue of Buffers
-    const std::deque<Buffer> &buffers() const { return _buffers; }
+    const Pieces &buffers() const { return _buffers; }
 
     //! \brief Append a BufferList
     void append(const BufferList &other);
@@ -88,7 +258,7 @@ class BufferList {
     void remove_prefix(size_t n);
 
     //! \brief Size of the string
-    size_t size() const;
+    size_t size() const { return _size; }
 
     //! \brief Make a copy to a new std::string
     std::string concatenate() const;
@@ -96,12 +266,20 @@ class BufferList {
 
 //! \brief A non-owning temporary view (similar to std::string_view) of a discontiguous string
 class BufferViewList {
-    std::deque<std::string_view> _views{};
+  public:
+    //! The pieces are kept as `iovec` structures, so that they can be passed to the kernel as they are
+    using Pieces = InlineDeque<iovec, 4>;
+
+  private:
+    Pieces _views{};
+    size_t _size{0};  //!< Total bytes in `_views`
 
   public:
     //! \name Constructors
     //!@{
 
+    BufferViewList() = default;
+
     //! \brief Construct from a std::string
     BufferViewList(const std::string &str) : BufferViewList(std::string_view(str)) {}
 
@@ -112,18 +290,27 @@ class BufferViewList {
     BufferViewList(const BufferList &buffers);
 
     //! \brief Construct from a std::string_view
-    BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
+    BufferViewList(std::string_view str) { append(str); }
     //!@}
 
+    //! \brief Append a view to the end of the list
+    void append(std::string_view str) {
+        _views.push_back({const_cast<char *>(str.data()), str.size()});
+        _size += str.size();
+    }
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     void remove_prefix(size_t n);
 
     //! \brief Size of the string
-    size_t size() const;
+    size_t size() const { return _size; }
+
+    //! \brief The pieces as `iovec` structures, without copying them
+    //! \note used for system calls that write discontiguous buffers, e.g. [writev(2)](\ref man2::writev)
+    //! and [sendmsg(2)](\ref man2::sendmsg); `iovecs().data()` is valid until the list is modified
+    const Pieces &iovecs() const { return _views; }
 
     //! \brief Convert to a vector of `iovec` structures
-    //! \note used for system calls that write discontiguous buffers,
-    //! e.g. [writev(2)](\ref man2::writev) and [sendmsg(2)](\ref man2::sendmsg)
     std::vector<iovec> as_iovecs() const;
 };
 
@@ -0,0 +1,27 @@
+#include "eventfd.hh"
+
+#include "util.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+EventFD::EventFD() : FileDescriptor(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {}
+
+//! \details Does not update the FileDescriptor write count, so a producer thread can call this
+//! while the consumer's EventLoop is looking at the read count.
+void EventFD::notify() {
+    const uint64_t one = 1;
+    SystemCall("write", ::write(fd_num(), &one, sizeof(one)));
+}
+
+//! \details Counts as a read for the purposes of EventLoop's busy-wait detection.
+bool EventFD::clear() {
+    uint64_t counter = 0;
+    const ssize_t bytes_read = SystemCall("read", ::read(fd_num(), &counter, sizeof(counter)), EAGAIN);
+    register_read();
+    return bytes_read > 0 and counter > 0;
+}
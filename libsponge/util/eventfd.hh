@@ -0,0 +1,20 @@
+#ifndef SPONGE_LIBSPONGE_EVENTFD_HH
+#define SPONGE_LIBSPONGE_EVENTFD_HH
+
+#include "file_descriptor.hh"
+
+//! A non-blocking FileDescriptor to a Linux [eventfd](\ref man2::eventfd) counter, used to wake up an EventLoop
+class EventFD : public FileDescriptor {
+  public:
+    //! Create a new eventfd whose counter starts at zero
+    EventFD();
+
+    //! Add one to the counter, making the fd readable (safe to call from any thread)
+    void notify();
+
+    //! Reset the counter to zero so the fd is no longer readable
+    //! \returns `true` if the counter was nonzero, i.e. at least one notify() happened since the last clear()
+    bool clear();
+};
+
+#endif  // SPONGE_LIBSPONGE_EVENTFD_HH
@@ -73,11 +73,33 @@ string FileDescriptor::read(const size_t limit) {
     return ret;
 }
 
+//! \param[in] buffers are the regions to fill, in order; fewer bytes than their total size may be read
+//! \param[in] count is the number of regions
+//! \returns the number of bytes read
+size_t FileDescriptor::readv(const iovec *buffers, const size_t count) {
+    size_t size_to_read = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_to_read += buffers[i].iov_len;
+    }
+
+    const ssize_t bytes_read = SystemCall("readv", ::readv(fd_num(), buffers, count));
+    if (size_to_read > 0 && bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+    if (bytes_read > static_cast<ssize_t>(size_to_read)) {
+        throw runtime_error("readv() read more than requested");
+    }
+
+    register_read();
+
+    return bytes_read;
+}
+
 size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
     size_t total_bytes_written = 0;
 
     do {
-        auto iovecs = buffer.as_iovecs();
+        const auto &iovecs = buffer.iovecs();
 
         const ssize_t bytes_written = SystemCall("writev", ::writev(fd_num(), iovecs.data(), iovecs.size()));
         if (bytes_written == 0 and buffer.size() != 0) {
@@ -98,6 +120,28 @@ size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
     return total_bytes_written;
 }
 
+//! \param[in] buffers are the regions to write, in order; fewer bytes than their total size may be written
+//! \param[in] count is the number of regions
+//! \returns the number of bytes written
+size_t FileDescriptor::writev(const iovec *buffers, const size_t count) {
+    size_t size_to_write = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_to_write += buffers[i].iov_len;
+    }
+
+    const ssize_t bytes_written = SystemCall("writev", ::writev(fd_num(), buffers, count));
+    if (bytes_written == 0 and size_to_write != 0) {
+        throw runtime_error("write returned 0 given non-empty input buffer");
+    }
+    if (bytes_written > static_cast<ssize_t>(size_to_write)) {
+        throw runtime_error("write wrote more than length of input buffer");
+    }
+
+    register_write();
+
+    return bytes_written;
+}
+
 void FileDescriptor::set_blocking(const bool blocking_state) {
     int flags = SystemCall("fcntl", fcntl(fd_num(), F_GETFL));
     if (blocking_state) {
@@ -61,6 +61,9 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! Read into `count` caller-provided regions with one [readv(2)](\ref man2::readv)
+    size_t readv(const iovec *buffers, const size_t count);
+
     //! Write a string, possibly blocking until all is written
     size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
 
@@ -70,6 +73,9 @@ class FileDescriptor {
     //! Write a buffer (or list of buffers), possibly blocking until all is written
     size_t write(BufferViewList buffer, const bool write_all = true);
 
+    //! Write from `count` caller-provided regions with one [writev(2)](\ref man2::writev)
+    size_t writev(const iovec *buffers, const size_t count);
+
     //! Close the underlying file descriptor
     void close() { _internal_fd->close(); }
 
@@ -1,7 +1,22 @@
 #include "parser.hh"
 
+#include <cstring>
+#include <endian.h>
+
 using namespace std;
 
+//! Convert between network (big-endian) and host byte order; the conversion is its own inverse
+template <typename T>
+static T swap_network_order(const T val) {
+    if constexpr (sizeof(T) == 4) {
+        return htobe32(val);
+    } else if constexpr (sizeof(T) == 2) {
+        return htobe16(val);
+    } else {
+        return val;
+    }
+}
+
 //! \param[in] r is the ParseResult to show
 //! \returns a string representation of the ParseResult
 string as_string(const ParseResult r) {
@@ -31,15 +46,11 @@ T NetParser::_parse_int() {
         return 0;
     }
 
-    T ret = 0;
-    for (size_t i = 0; i < len; i++) {
-        ret <<= 8;
-        ret += uint8_t(_buffer.at(i));
-    }
-
+    T ret;
+    memcpy(&ret, _buffer.str().data(), len);
     _buffer.remove_prefix(len);
 
-    return ret;
+    return swap_network_order(ret);
 }
 
 void NetParser::remove_prefix(const size_t n) {
@@ -52,11 +63,8 @@ void NetParser::remove_prefix(const size_t n) {
 
 template <typename T>
 void NetUnparser::_unparse_int(string &s, T val) {
-    constexpr size_t len = sizeof(T);
-    for (size_t i = 0; i < len; ++i) {
-        const uint8_t the_byte = (val >> ((len - i - 1) * 8)) & 0xff;
-        s.push_back(the_byte);
-    }
+    const T network_order = swap_network_order(val);
+    s.append(reinterpret_cast<const char *>(&network_order), sizeof(T));
 }
 
 uint32_t NetParser::u32() { return _parse_int<uint32_t>(); }
@@ -5,9 +5,15 @@
 #include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <cstring>
 #include <sstream>
+#include <stdexcept>
 #include <sys/socket.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -69,6 +75,131 @@ mt19937 get_random_generator() {
     return mt19937(seed);
 }
 
+//! \name Checksum kernels
+//! Each one sums `nwords` 64-bit words starting at `data`, in native byte order, as pairs of 32-bit halves.
+//! The one's complement sum does not depend on how the data is cut into 16-bit multiples (RFC 1071), so
+//! the result folds down to the same checksum as summing big-endian 16-bit words one at a time.
+//! With `COPY`, each word is also stored to `out` while it is in a register.
+//!@{
+
+template <bool COPY>
+static uint64_t sum_words_portable(const char *data, const size_t nwords, char *out) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < nwords; i++) {
+        uint64_t word;
+        memcpy(&word, data + 8 * i, sizeof(word));
+        if constexpr (COPY) {
+            memcpy(out + 8 * i, &word, sizeof(word));
+        }
+        sum += (word & 0xffffffff) + (word >> 32);
+    }
+    return sum;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+template <bool COPY>
+__attribute__((target("sse2"))) static uint64_t sum_words_sse2(const char *data, const size_t nwords, char *out) {
+    const __m128i low_halves = _mm_set1_epi64x(0xffffffff);
+    __m128i sum = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= nwords; i += 2) {
+        const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 8 * i));
+        if constexpr (COPY) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8 * i), words);
+        }
+        sum = _mm_add_epi64(sum, _mm_and_si128(words, low_halves));
+        sum = _mm_add_epi64(sum, _mm_srli_epi64(words, 32));
+    }
+    array<uint64_t, 2> lanes{};
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes.data()), sum);
+    return lanes[0] + lanes[1] + sum_words_portable<COPY>(data + 8 * i, nwords - i, COPY ? out + 8 * i : out);
+}
+
+template <bool COPY>
+__attribute__((target("avx2"))) static uint64_t sum_words_avx2(const char *data, const size_t nwords, char *out) {
+    const __m256i low_halves = _mm256_set1_epi64x(0xffffffff);
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= nwords; i += 4) {
+        const __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 8 * i));
+        if constexpr (COPY) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 8 * i), words);
+        }
+        sum = _mm256_add_epi64(sum, _mm256_and_si256(words, low_halves));
+        sum = _mm256_add_epi64(sum, _mm256_srli_epi64(words, 32));
+    }
+    array<uint64_t, 4> lanes{};
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes.data()), sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           sum_words_portable<COPY>(data + 8 * i, nwords - i, COPY ? out + 8 * i : out);
+}
+#endif
+//!@}
+
+using SumWords = uint64_t (*)(const char *, size_t, char *);
+
+//! A kernel's two variants: summing only, and copying while summing
+struct KernelFunctions {
+    SumWords sum;
+    SumWords copy_and_sum;
+};
+
+static KernelFunctions kernel_functions(const InternetChecksum::Kernel kernel) {
+    switch (kernel) {
+#if defined(__x86_64__) || defined(__i386__)
+        case InternetChecksum::Kernel::SSE2:
+            return {sum_words_sse2<false>, sum_words_sse2<true>};
+        case InternetChecksum::Kernel::AVX2:
+            return {sum_words_avx2<false>, sum_words_avx2<true>};
+#endif
+        default:
+            return {sum_words_portable<false>, sum_words_portable<true>};
+    }
+}
+
+//! The kernel in use, chosen once at startup
+static KernelFunctions &selected_kernel() {
+    static KernelFunctions selected = [] {
+        for (const auto kernel : {InternetChecksum::Kernel::AVX2, InternetChecksum::Kernel::SSE2}) {
+            if (InternetChecksum::supported(kernel)) {
+                return kernel_functions(kernel);
+            }
+        }
+        return kernel_functions(InternetChecksum::Kernel::Portable);
+    }();
+    return selected;
+}
+
+//! Fold a sum to 16 bits with end-around carry; a nonzero sum stays nonzero
+static uint32_t fold(uint64_t sum) {
+    sum = (sum >> 32) + (sum & 0xffffffff);  // at most 33 bits
+    sum = (sum >> 16) + (sum & 0xffff);      // at most 18 bits
+    sum = (sum >> 16) + (sum & 0xffff);      // at most 17 bits, and then only if the low 16 are small
+    return (sum >> 16) + (sum & 0xffff);
+}
+
+bool InternetChecksum::supported(const Kernel kernel) {
+    switch (kernel) {
+#if defined(__x86_64__) || defined(__i386__)
+        case Kernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        case Kernel::Portable:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void InternetChecksum::use(const Kernel kernel) {
+    if (not supported(kernel)) {
+        throw runtime_error("InternetChecksum: kernel not supported on this machine");
+    }
+    selected_kernel() = kernel_functions(kernel);
+}
+
 //! \note This class returns the checksum in host byte order.
 //!       See https://commandcenter.blogspot.com/2012/04/byte-order-fallacy.html for rationale
 //! \details This class can be used to either check or compute an Internet checksum
@@ -86,15 +217,55 @@ mt19937 get_random_generator() {
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
 InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
 
-void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+//! \details Equivalent to adding one byte at a time, alternating between the high and low halves of
+//! 16-bit words, so data may be split across calls at any byte boundary.
+void InternetChecksum::add(std::string_view data) { add(data, nullptr); }
+
+//! \details The copy happens in the same pass as the summing, so each byte is loaded only once.
+//! \param[out] out receives a copy of `data`; it must have room for `data.size()` bytes
+void InternetChecksum::add_copy(char *out, std::string_view data) { add(data, out); }
+
+void InternetChecksum::add(std::string_view data, char *out) {
+    uint64_t sum = _sum;
+    if (_parity and not data.empty()) {
+        // finish the 16-bit word started by the previous call
+        sum += uint8_t(data.front());
+        if (out) {
+            *out++ = data.front();
         }
-        _sum += val;
-        _parity = !_parity;
+        data.remove_prefix(1);
+        _parity = false;
+    }
+
+    const size_t nwords = data.size() / 8;
+    const KernelFunctions &kernel = selected_kernel();
+    uint64_t words_sum = fold((out ? kernel.copy_and_sum : kernel.sum)(data.data(), nwords, out));
+    data.remove_prefix(8 * nwords);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    words_sum = ((words_sum & 0xff) << 8) | (words_sum >> 8);
+#endif
+    sum += words_sum;
+
+    if (out) {
+        memcpy(out + 8 * nwords, data.data(), data.size());
+    }
+    for (size_t i = 0; i + 1 < data.size(); i += 2) {
+        sum += (uint16_t{uint8_t(data[i])} << 8) | uint8_t(data[i + 1]);
+    }
+    if (data.size() % 2 == 1) {
+        sum += uint16_t{uint8_t(data.back())} << 8;
+        _parity = true;
+    }
+
+    _sum = fold(sum);
+}
+
+//! \details The bytes added so far must be of even length, so that the sums line up on 16-bit words.
+void InternetChecksum::add_sum(const uint32_t partial_sum) {
+    if (_parity) {
+        throw runtime_error("InternetChecksum: add_sum() after an odd number of bytes");
     }
+    _sum = fold(uint64_t{_sum} + partial_sum);
 }
 
 uint16_t InternetChecksum::value() const {
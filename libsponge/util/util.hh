@@ -9,6 +9,7 @@
 #include <ostream>
 #include <random>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <vector>
 
@@ -53,14 +54,41 @@ uint64_t timestamp_ms();
 
 //! The internet checksum algorithm
 class InternetChecksum {
+  public:
+    //! Implementations of the loop that sums the bulk of the data
+    enum class Kernel {
+        Portable,  //!< 64-bit words, in plain C++
+        SSE2,      //!< 128-bit vectors (x86 only)
+        AVX2       //!< 256-bit vectors (x86 only)
+    };
+
   private:
     uint32_t _sum;
     bool _parity{};
 
+    //! Add `data`, copying it to `out` along the way unless `out` is null
+    void add(std::string_view data, char *out);
+
   public:
     InternetChecksum(const uint32_t initial_sum = 0);
     void add(std::string_view data);
     uint16_t value() const;
+
+    //! Copy `data` to `out` and add it to the checksum, in a single pass
+    void add_copy(char *out, std::string_view data);
+
+    //! \brief The running one's complement sum, folded to 16 bits
+    //! \note Only combinable with other sums (via add_sum() or the constructor) after an even number of bytes
+    uint32_t sum() const { return _sum; }
+
+    //! Add a sum previously taken from sum(), as if the bytes it covers were added here
+    void add_sum(const uint32_t partial_sum);
+
+    //! \returns whether this machine can run `kernel`
+    static bool supported(const Kernel kernel);
+
+    //! Use `kernel` for every checksum from now on (by default, the fastest supported one is used)
+    static void use(const Kernel kernel);
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
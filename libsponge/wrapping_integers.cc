@@ -1,22 +1,11 @@
 #include "wrapping_integers.hh"
 
-// Dummy implementation of a 32-bit wrapping integer
-
-// For Lab 2, please replace with a real implementation that passes the
-// automated checks run by `make check_lab2`.
-
-template <typename... Targs>
-void DUMMY_CODE(Targs &&... /* unused */) {}
-
 using namespace std;
 
 //! Transform an "absolute" 64-bit sequence number (zero-indexed) into a WrappingInt32
 //! \param n The input absolute 64-bit sequence number
 //! \param isn The initial sequence number
-WrappingInt32 wrap(uint64_t n, WrappingInt32 isn) {
-    DUMMY_CODE(n, isn);
-    return WrappingInt32{0};
-}
+WrappingInt32 wrap(uint64_t n, WrappingInt32 isn) { return WrappingInt32{static_cast<uint32_t>(n) + isn.raw_value()}; }
 
 //! Transform a WrappingInt32 into an "absolute" 64-bit sequence number (zero-indexed)
 //! \param n The relative sequence number
@@ -29,6 +18,18 @@ WrappingInt32 wrap(uint64_t n, WrappingInt32 isn) {
 //! and the other stream runs from the remote TCPSender to the local TCPReceiver and
 //! has a different ISN.
 uint64_t unwrap(WrappingInt32 n, WrappingInt32 isn, uint64_t checkpoint) {
-    DUMMY_CODE(n, isn, checkpoint);
-    return {};
+    constexpr uint64_t WRAP = 1ULL << 32;
+    const uint32_t offset = n.raw_value() - isn.raw_value();
+    const uint64_t base = (checkpoint & ~(WRAP - 1)) + offset;
+    const auto distance = [checkpoint](const uint64_t x) { return x > checkpoint ? x - checkpoint : checkpoint - x; };
+
+    // the candidates are `offset` in the checkpoint's 2^32 block and in the blocks either side of it
+    uint64_t best = base;
+    if (base >= WRAP and distance(base - WRAP) < distance(best)) {
+        best = base - WRAP;
+    }
+    if (distance(base + WRAP) < distance(best)) {
+        best = base + WRAP;
+    }
+    return best;
 }
@@ -0,0 +1,77 @@
+#include "buffer.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+static string view_contents(const BufferViewList &views) {
+    string ret;
+    for (const auto &iov : views.iovecs()) {
+        ret.append(static_cast<const char *>(iov.iov_base), iov.iov_len);
+    }
+    return ret;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // lists that stay inline, spill to the heap, and come back, trimmed a random amount at a time
+        for (size_t rep = 0; rep < 1000; ++rep) {
+            BufferList list;
+            string expected;
+            const size_t pieces = rd() % 12;
+            for (size_t i = 0; i < pieces; ++i) {
+                string piece(rd() % 20, 0);
+                generate(piece.begin(), piece.end(), [&] { return 'a' + (rd() % 26); });
+                expected.append(piece);
+                list.append(BufferList(move(piece)));
+            }
+
+            BufferViewList views{list};
+            while (true) {
+                if (list.size() != expected.size() or list.concatenate() != expected) {
+                    throw runtime_error("BufferList contents wrong");
+                }
+                if (views.size() != expected.size() or view_contents(views) != expected or
+                    views.as_iovecs().size() != views.iovecs().size()) {
+                    throw runtime_error("BufferViewList contents wrong");
+                }
+                if (expected.empty()) {
+                    break;
+                }
+
+                const size_t n = rd() % (expected.size() + 1);
+                list.remove_prefix(n);
+                views.remove_prefix(n);
+                expected.erase(0, n);
+
+                // appending after a partial drain slides the inline pieces forward
+                if (rd() % 4 == 0) {
+                    list.append(BufferList(string("xyz")));
+                    views = BufferViewList{list};
+                    expected.append("xyz");
+                }
+            }
+        }
+
+        // removing past the end is an error
+        BufferViewList views{"abc"};
+        bool threw = false;
+        try {
+            views.remove_prefix(4);
+        } catch (const out_of_range &) {
+            threw = true;
+        }
+        if (not threw) {
+            throw runtime_error("BufferViewList::remove_prefix past the end did not throw");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include "buffer.hh"
+
+#include <exception>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+int main() {
+    try {
+        // a chunk released by its last Buffer is handed out again
+        {
+            string chunk = BufferPool::take();
+            if (chunk.size() != 0 or chunk.capacity() < BufferPool::CHUNK_SIZE) {
+                throw runtime_error("take() did not return an empty chunk");
+            }
+            chunk.assign("hello, world");
+            const char *storage = chunk.data();
+
+            Buffer buf{move(chunk)};
+            Buffer copy = buf;
+            buf.remove_prefix(7);
+            copy.remove_suffix(7);
+            if (buf.str() != "world" or copy.str() != "hello") {
+                throw runtime_error("pooled Buffer trimmed incorrectly");
+            }
+
+            buf = Buffer{};
+            if (BufferPool::take().data() == storage) {
+                throw runtime_error("chunk recycled while still referenced");
+            }
+            copy.remove_prefix(5);
+            if (copy.size() != 0 or BufferPool::take().data() != storage) {
+                throw runtime_error("chunk not recycled after the last Buffer let go");
+            }
+        }
+
+        // strings the pool does not own are never recycled: the chunk pooled before them is the next one out
+        {
+            string chunk = BufferPool::take();
+            const char *pooled = chunk.data();
+            { Buffer released{move(chunk)}; }
+            string small = "a string that is too short to pool";
+            string big(4 * BufferPool::CHUNK_SIZE, 'x');
+            const char *small_storage = small.data();
+            const char *big_storage = big.data();
+            { Buffer a{move(small)}, b{move(big)}; }
+            const string next = BufferPool::take();
+            if (next.data() != pooled) {
+                throw runtime_error("chunk-sized string not recycled");
+            }
+            if (next.data() == small_storage or next.data() == big_storage) {
+                throw runtime_error("recycled a string that is not chunk-sized");
+            }
+        }
+
+        // Buffers can be released on a thread other than the one that took their chunk, which then reuses it
+        {
+            string payload = BufferPool::take();
+            payload.assign(1000, 'z');
+            const char *storage = payload.data();
+            Buffer buf{move(payload)};
+            bool ok = false;
+            thread other([&ok, storage, buf = move(buf)]() mutable {
+                ok = buf.size() == 1000;
+                buf = Buffer{};
+                // take the same size from malloc first, so a freed (not recycled) chunk can't come back from take()
+                string unpooled;
+                unpooled.reserve(BufferPool::CHUNK_SIZE);
+                ok = ok and BufferPool::take().data() == storage;
+            });
+            other.join();
+            if (not ok) {
+                throw runtime_error("chunk not recycled by the thread that released it");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
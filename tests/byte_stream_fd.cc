@@ -0,0 +1,112 @@
+#include "byte_stream.hh"
+#include "file_descriptor.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+static pair<FileDescriptor, FileDescriptor> make_pipe() {
+    int fds[2];
+    SystemCall("pipe", ::pipe(static_cast<int *>(fds)));
+    return {FileDescriptor(fds[0]), FileDescriptor(fds[1])};
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t NREPS = 2000;
+        const size_t MAX_CHUNK = 300;
+        const size_t MAX_IN_PIPE = 16384;
+
+        for (const auto storage : {ByteStream::Storage::Ring, ByteStream::Storage::Chunked}) {
+            for (const size_t capacity : {size_t(1), size_t(7), size_t(256), size_t(1000)}) {
+                auto [source_read, source_write] = make_pipe();
+                auto [sink_read, sink_write] = make_pipe();
+                source_read.set_blocking(false);
+
+                ByteStream stream{capacity, storage};
+                string sent, received;
+                size_t in_source = 0;
+
+                for (size_t i = 0; i < NREPS; ++i) {
+                    // keep well under the pipe's buffer so the blocking write never waits
+                    if (in_source < MAX_IN_PIPE) {
+                        string d(rd() % MAX_CHUNK, 0);
+                        generate(d.begin(), d.end(), [&] { return 'a' + (rd() % 26); });
+                        source_write.write(d);
+                        sent.append(d);
+                        in_source += d.size();
+                    }
+
+                    // an empty pipe would make the non-blocking read fail with EAGAIN
+                    if (in_source > 0) {
+                        const size_t max = rd() % (MAX_CHUNK + 1);
+                        const size_t expected = min({max, in_source, stream.remaining_capacity()});
+                        if (stream.write_from(source_read, max) != expected) {
+                            throw runtime_error("write_from did not read what was available");
+                        }
+                        in_source -= expected;
+                    }
+                    if (stream.bytes_written() != sent.size() - in_source) {
+                        throw runtime_error("write_from accounting");
+                    }
+
+                    const size_t max = rd() % (MAX_CHUNK + 1);
+                    const size_t expected = min(max, stream.buffer_size());
+                    if (stream.read_into(sink_write, max) != expected) {
+                        throw runtime_error("read_into did not write what was buffered");
+                    }
+                    if (expected > 0) {
+                        received.append(sink_read.read(expected));
+                    }
+                    if (received != sent.substr(0, stream.bytes_read())) {
+                        throw runtime_error("read_into wrote the wrong bytes");
+                    }
+                }
+
+                source_write.close();
+                while (not source_read.eof()) {
+                    stream.write_from(source_read);
+                    stream.read_into(sink_write);
+                }
+                stream.end_input();
+                while (not stream.eof()) {
+                    stream.read_into(sink_write);
+                }
+                sink_write.close();
+                while (not sink_read.eof()) {
+                    received.append(sink_read.read());
+                }
+                if (received != sent) {
+                    throw runtime_error("stream did not copy every byte");
+                }
+            }
+        }
+
+        // reading nothing must not touch the fd, or add anything to the stream
+        for (const auto storage : {ByteStream::Storage::Ring, ByteStream::Storage::Chunked}) {
+            auto [source_read, source_write] = make_pipe();
+            source_write.write("abc");
+            ByteStream stream{2, storage};
+            if (stream.write_from(source_read, 0) != 0 or not stream.buffer_empty() or stream.bytes_written() != 0) {
+                throw runtime_error("an empty write_from wrote to the stream");
+            }
+            if (stream.write_from(source_read) != 2 or stream.write_from(source_read) != 0 or
+                stream.bytes_written() != 2) {
+                throw runtime_error("write_from into a full stream");
+            }
+            if (source_read.read() != "c") {
+                throw runtime_error("write_from into a full stream consumed bytes from the fd");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
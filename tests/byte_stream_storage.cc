@@ -0,0 +1,70 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t NREPS = 2000;
+        const size_t MAX_WRITE = 300;
+
+        for (const auto storage : {ByteStream::Storage::Ring, ByteStream::Storage::Chunked}) {
+            // capacities that are and aren't powers of two, so writes and peeks wrap around the ring
+            for (const size_t capacity : {size_t(1), size_t(7), size_t(256), size_t(1000)}) {
+                ByteStreamTestHarness test{"random writes and pops", capacity, storage};
+
+                string expected;
+                size_t written = 0, read = 0;
+                for (size_t i = 0; i < NREPS; ++i) {
+                    const size_t size = rd() % MAX_WRITE;
+                    string d(size, 0);
+                    generate(d.begin(), d.end(), [&] { return 'a' + (rd() % 26); });
+
+                    const size_t accepted = min(size, capacity - expected.size());
+                    switch (i % 3) {
+                        case 0:
+                            test.execute(Write{d}.with_bytes_written(accepted));
+                            break;
+                        case 1:
+                            test.execute(WriteMoved{d}.with_bytes_written(accepted));
+                            break;
+                        default:
+                            test.execute(WriteBuffer{d}.with_bytes_written(accepted));
+                            break;
+                    }
+                    expected.append(d.substr(0, accepted));
+                    written += accepted;
+
+                    test.execute(BufferSize{expected.size()});
+                    test.execute(RemainingCapacity{capacity - expected.size()});
+                    test.execute(Peek{expected});
+                    test.execute(PeekViews{expected.substr(0, size)});
+                    test.execute(PeekBuffers{expected.substr(0, size / 2)});
+
+                    const size_t pop_len = rd() % (expected.size() + 1);
+                    test.execute(Pop{pop_len});
+                    expected.erase(0, pop_len);
+                    read += pop_len;
+
+                    test.execute(Peek{expected});
+                    test.execute(BytesWritten{written});
+                    test.execute(BytesRead{read});
+                }
+
+                test.execute(EndInput{});
+                test.execute(Pop{expected.size()});
+                test.execute(Eof{true});
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
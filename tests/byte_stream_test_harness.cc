@@ -45,11 +45,14 @@ void ByteStreamAction::execute(ByteStream &) const {}
 
 ByteStreamAction::~ByteStreamAction() {}
 
-ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name,
+                                             const size_t capacity,
+                                             const ByteStream::Storage storage)
+    : _test_name(test_name), _byte_stream(capacity, storage) {
     std::ostringstream ss;
     ss << "Initialized with ("
-       << "capacity=" << capacity << ")";
+       << "capacity=" << capacity << ", storage=" << (storage == ByteStream::Storage::Ring ? "ring" : "chunked")
+       << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
@@ -97,11 +100,36 @@ void Write::execute(ByteStream &bs) const {
     }
 }
 
+// WriteMoved
+std::string WriteMoved::description() const { return "write \"" + _data + "\" to the stream as an rvalue"; }
+void WriteMoved::execute(ByteStream &bs) const {
+    auto bytes_written = bs.write(std::string(_data));
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
+// WriteBuffer
+std::string WriteBuffer::description() const { return "write \"" + _data + "\" to the stream as a Buffer"; }
+void WriteBuffer::execute(ByteStream &bs) const {
+    auto bytes_written = bs.write(Buffer(std::string(_data)));
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
 // Pop
 Pop::Pop(const size_t len) : _len(len) {}
 std::string Pop::description() const { return "pop " + to_string(_len); }
 void Pop::execute(ByteStream &bs) const { bs.pop_output(_len); }
 
+// SetWatermarks
+SetWatermarks::SetWatermarks(const size_t low, const size_t high) : _low(low), _high(high) {}
+std::string SetWatermarks::description() const {
+    return "set watermarks to " + to_string(_low) + " (low) and " + to_string(_high) + " (high)";
+}
+void SetWatermarks::execute(ByteStream &bs) const { bs.set_watermarks(_low, _high); }
+
 // InputEnded
 InputEnded::InputEnded(const bool input_ended) : _input_ended(input_ended) {}
 std::string InputEnded::description() const { return "input_ended: " + to_string(_input_ended); }
@@ -132,6 +160,16 @@ void Eof::execute(ByteStream &bs) const {
     }
 }
 
+// Writable
+Writable::Writable(const bool writable) : _writable(writable) {}
+std::string Writable::description() const { return "writable: " + to_string(_writable); }
+void Writable::execute(ByteStream &bs) const {
+    auto writable = bs.writable();
+    if (writable != _writable) {
+        throw ByteStreamExpectationViolation::property("writable", _writable, writable);
+    }
+}
+
 // BufferSize
 BufferSize::BufferSize(const size_t buffer_size) : _buffer_size(buffer_size) {}
 std::string BufferSize::description() const { return "buffer_size: " + to_string(_buffer_size); }
@@ -182,3 +220,28 @@ void Peek::execute(ByteStream &bs) const {
                                              output + "\"");
     }
 }
+
+// PeekViews
+PeekViews::PeekViews(const std::string &output) : _output(output) {}
+std::string PeekViews::description() const { return "\"" + _output + "\" in views of the front of the stream"; }
+void PeekViews::execute(ByteStream &bs) const {
+    std::string output;
+    for (const auto &iov : bs.peek_views(_output.size()).as_iovecs()) {
+        output.append(static_cast<const char *>(iov.iov_base), iov.iov_len);
+    }
+    if (output != _output) {
+        throw ByteStreamExpectationViolation("Expected \"" + _output + "\" in views of the stream, but found \"" +
+                                             output + "\"");
+    }
+}
+
+// PeekBuffers
+PeekBuffers::PeekBuffers(const std::string &output) : _output(output) {}
+std::string PeekBuffers::description() const { return "\"" + _output + "\" in buffers at the front of the stream"; }
+void PeekBuffers::execute(ByteStream &bs) const {
+    auto output = bs.peek_buffers(_output.size()).concatenate();
+    if (output != _output) {
+        throw ByteStreamExpectationViolation("Expected \"" + _output + "\" in buffers of the stream, but found \"" +
+                                             output + "\"");
+    }
+}
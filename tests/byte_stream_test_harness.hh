@@ -56,6 +56,20 @@ struct Write : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+//! Like Write, but hands the stream an rvalue string
+struct WriteMoved : public Write {
+    using Write::Write;
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
+//! Like Write, but hands the stream a Buffer
+struct WriteBuffer : public Write {
+    using Write::Write;
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct Pop : public ByteStreamAction {
     size_t _len;
 
@@ -64,6 +78,15 @@ struct Pop : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+struct SetWatermarks : public ByteStreamAction {
+    size_t _low;
+    size_t _high;
+
+    SetWatermarks(const size_t low, const size_t high);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct InputEnded : public ByteStreamExpectation {
     bool _input_ended;
 
@@ -88,6 +111,14 @@ struct Eof : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+struct Writable : public ByteStreamExpectation {
+    bool _writable;
+
+    Writable(const bool writable);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct BufferSize : public ByteStreamExpectation {
     size_t _buffer_size;
 
@@ -128,13 +159,31 @@ struct Peek : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+struct PeekViews : public ByteStreamExpectation {
+    std::string _output;
+
+    PeekViews(const std::string &output);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
+struct PeekBuffers : public ByteStreamExpectation {
+    std::string _output;
+
+    PeekBuffers(const std::string &output);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 class ByteStreamTestHarness {
     std::string _test_name;
     ByteStream _byte_stream;
     std::vector<std::string> _steps_executed{};
 
   public:
-    ByteStreamTestHarness(const std::string &test_name, const size_t capacity);
+    ByteStreamTestHarness(const std::string &test_name,
+                          const size_t capacity,
+                          const ByteStream::Storage storage = ByteStream::Storage::Ring);
 
     void execute(const ByteStreamTestStep &step);
 };
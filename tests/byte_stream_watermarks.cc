@@ -0,0 +1,63 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        for (const auto storage : {ByteStream::Storage::Ring, ByteStream::Storage::Chunked}) {
+            {
+                ByteStreamTestHarness test{"default watermarks", 4, storage};
+
+                test.execute(Writable{true});
+                test.execute(Write{"abcd"}.with_bytes_written(4));
+                test.execute(Writable{false});
+                test.execute(Pop{1});
+                test.execute(Writable{true});
+            }
+
+            {
+                ByteStreamTestHarness test{"hysteresis", 10, storage};
+
+                test.execute(SetWatermarks{3, 8});
+                test.execute(Write{"abcdefg"}.with_bytes_written(7));
+                test.execute(Writable{true});
+                test.execute(Write{"h"}.with_bytes_written(1));
+                test.execute(Writable{false});
+                test.execute(RemainingCapacity{2});
+
+                test.execute(Pop{4});
+                test.execute(Writable{false});
+                test.execute(Pop{1});
+                test.execute(Writable{true});
+                test.execute(Peek{"fgh"});
+
+                test.execute(Write{"ijklmnop"}.with_bytes_written(7));
+                test.execute(Writable{false});
+                test.execute(BufferSize{10});
+                test.execute(Pop{10});
+                test.execute(Writable{true});
+            }
+
+            {
+                ByteStreamTestHarness test{"watermarks set on a full buffer", 6, storage};
+
+                test.execute(Write{"abcdef"}.with_bytes_written(6));
+                test.execute(SetWatermarks{2, 100});
+                test.execute(Writable{false});
+                test.execute(Pop{3});
+                test.execute(Writable{false});
+                test.execute(Pop{1});
+                test.execute(Writable{true});
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
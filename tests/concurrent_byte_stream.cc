@@ -0,0 +1,88 @@
+#include "concurrent_byte_stream.hh"
+#include "eventloop.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // single-threaded: same semantics as ByteStream
+        {
+            ConcurrentByteStream stream{7};
+            if (stream.write("abcdefghij") != 7 or stream.remaining_capacity() != 0 or stream.buffer_size() != 7) {
+                throw runtime_error("write past capacity");
+            }
+            if (stream.read(3) != "abc" or stream.write("klm") != 3 or stream.peek_output(7) != "defgklm") {
+                throw runtime_error("wrap-around");
+            }
+            stream.end_input();
+            if (stream.eof() or stream.read(100) != "defgklm" or not stream.eof() or stream.bytes_read() != 10) {
+                throw runtime_error("eof");
+            }
+        }
+
+        // writer thread and reader thread, each driven by its own EventLoop
+        for (const size_t capacity : {size_t(1), size_t(100), size_t(4096)}) {
+            const size_t TOTAL = min(size_t(1024 * 1024), capacity * 16384);
+            string to_send(TOTAL, 0);
+            generate(to_send.begin(), to_send.end(), [&] { return rd(); });
+
+            ConcurrentByteStream stream{capacity};
+
+            thread writer([&] {
+                EventLoop loop;
+                size_t sent = 0;
+                auto chunk_rd = get_random_generator();
+                loop.add_rule(
+                    stream.writable_event(),
+                    Direction::In,
+                    [&] {
+                        stream.writable_event().clear();
+                        while (sent < TOTAL and stream.remaining_capacity() > 0) {
+                            const size_t len = min(TOTAL - sent, 1 + chunk_rd() % 3000);
+                            sent += stream.write(to_send.substr(sent, len));
+                        }
+                        if (sent == TOTAL) {
+                            stream.end_input();
+                        }
+                    },
+                    [&] { return sent < TOTAL; });
+                stream.writable_event().notify();
+                while (loop.wait_next_event(-1) != EventLoop::Result::Exit) {
+                }
+            });
+
+            EventLoop loop;
+            string received;
+            loop.add_rule(
+                stream.readable_event(),
+                Direction::In,
+                [&] {
+                    stream.readable_event().clear();
+                    while (not stream.buffer_empty()) {
+                        received.append(stream.read(stream.buffer_size()));
+                    }
+                },
+                [&] { return not stream.eof(); });
+            while (loop.wait_next_event(-1) != EventLoop::Result::Exit) {
+            }
+            writer.join();
+
+            if (received != to_send) {
+                throw runtime_error("bytes received across threads (capacity " + to_string(capacity) +
+                                    ") don't match bytes sent");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
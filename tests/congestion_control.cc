@@ -0,0 +1,128 @@
+#include "congestion_control.hh"
+#include "lossy_link_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! Run a 1 MB transfer over an 8 Mbit/s, 20 ms round-trip link with a 20 kB queue
+//! \details The ISN and the random drops are fixed, so every run with the same arguments goes the same way.
+static LossyLinkSimulation::Result simulate(const CongestionControl::Algorithm algorithm, const uint16_t loss_rate,
+                                            const string &data) {
+    TCPConfig cfg;
+    cfg.recv_capacity = 1 << 20;
+    cfg.send_capacity = 1 << 20;
+    cfg.adaptive_rto = true;
+    cfg.congestion_control = algorithm;
+    cfg.fixed_isn = WrappingInt32{0};
+
+    LossyLinkSimulation simulation{cfg, SimulatedLink::Config{}, loss_rate, 0};
+    const auto result = simulation.transfer(data, 600'000);
+    test_err_if(result.received != data, "stream was not delivered intact");
+    return result;
+}
+
+int main() {
+    try {
+        constexpr size_t mss = 1000;
+
+        // Reno: slow start, congestion avoidance, and the response to a timeout
+        {
+            auto reno = CongestionControl::make(CongestionControl::Algorithm::Reno, mss);
+            test_err_if(reno->window() != 10 * mss, "initial window should be ten segments");
+            for (unsigned i = 0; i < 10; i++) {
+                reno->on_ack(mss, 0, 0);
+            }
+            test_err_if(reno->window() != 20 * mss, "slow start should grow the window by one segment per ack");
+
+            reno->on_timeout(20 * mss);
+            test_err_if(reno->window() != mss or reno->slow_start_threshold() != 10 * mss,
+                        "a timeout should halve ssthresh and restart from one segment");
+            for (unsigned i = 0; i < 9; i++) {
+                reno->on_ack(mss, 0, 0);
+            }
+            test_err_if(reno->window() != 10 * mss, "slow start should end at ssthresh");
+            for (unsigned i = 0; i < 9; i++) {
+                reno->on_ack(mss, 0, 0);
+            }
+            test_err_if(reno->window() != 10 * mss, "congestion avoidance grew before a full window was acked");
+            reno->on_ack(mss, 0, 0);
+            test_err_if(reno->window() != 11 * mss, "congestion avoidance should grow one segment per window");
+
+            test_err_if(CongestionControl::make(CongestionControl::Algorithm::None, mss) != nullptr,
+                        "None should have no congestion window");
+        }
+
+        // an MSS settled by the peer's SYN resizes the initial window (RFC 6928)
+        for (const auto algorithm : {CongestionControl::Algorithm::Reno, CongestionControl::Algorithm::Cubic}) {
+            TCPSender sender{TCPConfig::DEFAULT_CAPACITY, 1000, WrappingInt32{0}};
+            sender.set_congestion_control(algorithm);
+            sender.set_max_payload_size(9000);
+            sender.fill_window();
+            test_err_if(sender.congestion_control()->window() != 2 * 9000,
+                        "a 9000-byte MSS should start with two segments");
+            sender.set_max_payload_size(536);
+            test_err_if(sender.congestion_control()->window() != 10 * 536,
+                        "a 536-byte MSS should start with ten segments");
+        }
+
+        // CUBIC: backs off to 70%, then grows back to the old window after K seconds, and past it afterwards
+        {
+            auto cubic = CongestionControl::make(CongestionControl::Algorithm::Cubic, mss);
+            cubic->on_timeout(10 * mss);
+            test_err_if(cubic->window() != mss or cubic->slow_start_threshold() != 7 * mss,
+                        "a timeout should set ssthresh to 70% of the window");
+            for (unsigned i = 0; i < 6; i++) {
+                cubic->on_ack(mss, 0, 0);
+            }
+            test_err_if(cubic->window() != 7 * mss, "slow start should end at ssthresh");
+
+            // K = cbrt((10 - 7) / 0.4), just under two seconds; ack one segment every 100 ms
+            uint64_t now = 0;
+            for (; now < 1900; now += 100) {
+                cubic->on_ack(mss, now, 0);
+            }
+            test_err_if(cubic->window() <= 7 * mss or cubic->window() > 10 * mss,
+                        "CUBIC should approach the old window without passing it");
+            for (; now < 5000; now += 100) {
+                cubic->on_ack(mss, now, 0);
+            }
+            test_err_if(cubic->window() <= 12 * mss, "CUBIC should probe beyond the old window");
+        }
+
+        // whole transfers over a bottleneck link
+        {
+            auto rd = get_random_generator();
+            string data(1'000'000, 0);
+            generate(data.begin(), data.end(), [&] { return rd(); });
+
+            const auto uncontrolled = simulate(CongestionControl::Algorithm::None, 0, data);
+            for (const auto algorithm : {CongestionControl::Algorithm::Reno,
+                                         CongestionControl::Algorithm::NewReno,
+                                         CongestionControl::Algorithm::Cubic}) {
+                const auto controlled = simulate(algorithm, 0, data);
+                test_err_if(controlled.queue_drops >= uncontrolled.queue_drops / 2,
+                            "congestion control should overflow the bottleneck queue less often");
+                test_err_if(controlled.segments_sent >= uncontrolled.segments_sent,
+                            "congestion control should retransmit less");
+
+                // about 2% random loss in each direction
+                simulate(algorithm, 1300, data);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+#include "congestion_control.hh"
+#include "lossy_link_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_fixtures.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! A connected sender recovering with `algorithm`, with ten 1000-byte segments in flight from absolute seqno 1
+static TCPSender sender_with_flight(const CongestionControl::Algorithm algorithm, const WrappingInt32 isn) {
+    TCPSender sender = connected_sender(isn);
+    sender.set_fast_retransmit(true);
+    sender.set_congestion_control(algorithm);
+    test_err_if(write_and_send(sender, string(10000, 'x')) != 10 or sender.bytes_in_flight() != 10000,
+                "initial flight not sent");
+    return sender;
+}
+
+//! Send the sender `count` acks of `ackno`
+static void acks(TCPSender &sender, const WrappingInt32 ackno, const unsigned count, const size_t window = 60000) {
+    for (unsigned i = 0; i < count; i++) {
+        sender.ack_received(ackno, window);
+    }
+}
+
+int main() {
+    try {
+        const WrappingInt32 isn{0};
+
+        // the third duplicate ack retransmits the lost segment, and recovery inflates the window
+        {
+            TCPSender sender = sender_with_flight(CongestionControl::Algorithm::Reno, isn);
+            const CongestionControl &cc = *sender.congestion_control();
+            acks(sender, isn + 1001, 1);
+            sender.segments_out() = {};
+            acks(sender, isn + 1001, 2);
+            test_err_if(not sender.segments_out().empty() or sender.in_recovery(), "retransmitted on two duplicates");
+            const size_t flight = sender.bytes_in_flight();
+            acks(sender, isn + 1001, 1);
+            test_err_if(not sender.in_recovery() or sender.segments_out().size() != 1, "no fast retransmit");
+            test_err_if(sender.segments_out().front().header().seqno != isn + 1001, "retransmitted the wrong segment");
+            test_err_if(cc.slow_start_threshold() != flight / 2 or cc.window() != flight / 2 + 3000,
+                        "fast retransmit should halve the flight, then inflate by three segments");
+            sender.segments_out() = {};
+
+            sender.stream_in().write(string(5000, 'y'));
+            acks(sender, isn + 1001, 3);
+            test_err_if(cc.window() != flight / 2 + 6000,
+                        "each further duplicate should inflate the window by a segment");
+            test_err_if(sender.segments_out().empty(), "an inflated window should send new data");
+            sender.segments_out() = {};
+
+            // Reno: a partial ack ends recovery
+            acks(sender, isn + 3001, 1);
+            test_err_if(sender.in_recovery() or cc.window() != flight / 2, "a new ack should deflate the window");
+        }
+
+        // NewReno: partial acks retransmit the next hole, and only a full ack ends recovery
+        {
+            TCPSender sender = sender_with_flight(CongestionControl::Algorithm::NewReno, isn);
+            const CongestionControl &cc = *sender.congestion_control();
+            acks(sender, isn + 1001, 1);
+            const size_t flight = sender.bytes_in_flight();
+            acks(sender, isn + 1001, 3);
+            sender.segments_out() = {};
+
+            acks(sender, isn + 3001, 1);
+            test_err_if(not sender.in_recovery(), "a partial ack ended NewReno's recovery");
+            test_err_if(sender.segments_out().empty() or sender.segments_out().front().header().seqno != isn + 3001,
+                        "a partial ack should retransmit the next hole");
+            test_err_if(cc.window() != flight / 2 + 3000 - 2000 + 1000,
+                        "a partial ack should deflate by the data acked, less one segment");
+            sender.segments_out() = {};
+
+            acks(sender, isn + 10001, 1);
+            test_err_if(sender.in_recovery() or cc.window() != flight / 2,
+                        "a full ack should end recovery at ssthresh");
+        }
+
+        // without fast retransmit, only the timer retransmits
+        {
+            TCPSender sender = connected_sender(isn);
+            write_and_send(sender, string(3000, 'x'));
+            acks(sender, isn + 1, 5);
+            test_err_if(not sender.segments_out().empty() or sender.in_recovery(), "retransmitted on duplicate acks");
+        }
+
+        // a window update isn't a duplicate ack
+        {
+            TCPSender sender = sender_with_flight(CongestionControl::Algorithm::None, isn);
+            for (size_t window = 60000; window > 59996; window--) {
+                sender.ack_received(isn + 1, window);
+            }
+            test_err_if(not sender.segments_out().empty(), "window updates triggered a fast retransmit");
+        }
+
+        // over a lossy link, recovering on duplicate acks beats waiting for timeouts
+        {
+            auto rd = get_random_generator();
+            string data(1'000'000, 0);
+            generate(data.begin(), data.end(), [&] { return rd(); });
+
+            // summed over a few transfers, as a lost retransmission still costs a timeout either way
+            uint64_t duration[2] = {};
+            for (const bool fast_retransmit : {false, true}) {
+                TCPConfig cfg;
+                cfg.recv_capacity = 1 << 20;
+                cfg.adaptive_rto = true;
+                cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+                cfg.fast_retransmit = fast_retransmit;
+
+                for (uint32_t seed = 0; seed < 5; seed++) {
+                    // about 1% random loss in each direction, drawn the same way with and without fast retransmit
+                    LossyLinkSimulation simulation{cfg, SimulatedLink::Config{}, 650, seed};
+                    const auto result = simulation.transfer(data, 600'000);
+                    test_err_if(result.received != data, "stream was not delivered intact");
+                    duration[fast_retransmit] += result.duration_ms;
+                }
+            }
+            test_err_if(duration[true] >= duration[false], "fast retransmit didn't speed up a lossy transfer");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
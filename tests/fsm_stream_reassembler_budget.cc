@@ -0,0 +1,137 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+static constexpr size_t OVERHEAD = StreamReassembler::PENDING_ENTRY_OVERHEAD;
+
+int main() {
+    try {
+        // single-byte fragments: the ones nearest the output survive
+        {
+            StreamReassembler buf{1000};
+            buf.set_memory_budget(10 * (OVERHEAD + 1));
+            for (size_t i = 1; i < 100; i += 2) {
+                buf.push_substring("x", i, false);
+                if (buf.memory_footprint() > 10 * (OVERHEAD + 1)) {
+                    throw runtime_error("footprint exceeds the budget");
+                }
+            }
+            if (buf.unassembled_bytes() != 10) {
+                throw runtime_error("expected 10 fragments to be kept, not " + to_string(buf.unassembled_bytes()));
+            }
+
+            buf.push_substring(string(19, 'x'), 0, false);
+            if (buf.stream_out().bytes_written() != 20 or not buf.empty()) {
+                throw runtime_error("the kept fragments were not the nearest ones");
+            }
+        }
+
+        // touching slices are coalesced before anything is dropped
+        {
+            StreamReassembler buf{1000};
+            buf.push_substring(string(10, 'b'), 20, false);
+            buf.push_substring(string(10, 'd'), 40, false);
+            buf.push_substring(string(10, 'a') + string(10, 'b') + string(10, 'c') + string(10, 'd'), 10, true);
+            if (buf.memory_footprint() != 4 * OVERHEAD + 40) {
+                throw runtime_error("unexpected footprint of four slices");
+            }
+
+            buf.set_memory_budget(OVERHEAD + 40, StreamReassembler::Eviction::Coalesce);
+            if (buf.unassembled_bytes() != 40 or buf.memory_footprint() != OVERHEAD + 40) {
+                throw runtime_error("touching slices were not coalesced");
+            }
+
+            buf.push_substring(string(10, 'z'), 0, false);
+            const string expected = string(10, 'z') + string(10, 'a') + string(10, 'b') + string(10, 'c') +
+                                    string(10, 'd');
+            if (buf.stream_out().read(50) != expected or not buf.stream_out().eof()) {
+                throw runtime_error("coalesced bytes were reassembled incorrectly");
+            }
+        }
+
+        // small slices cut from large received strings are copied, so the budget bounds the memory really held
+        {
+            StreamReassembler buf{100'000};
+            buf.set_memory_budget(10 * (OVERHEAD + 10));
+            for (size_t i = 1; i < 100; i++) {
+                Buffer datagram{string(64 * 1024, 'x')};
+                datagram.remove_prefix(1000);
+                datagram.remove_suffix(datagram.size() - 10);
+                buf.push_substring(move(datagram), 100 * i, false);
+                if (buf.memory_footprint() > 10 * (OVERHEAD + 10)) {
+                    throw runtime_error("footprint exceeds the budget");
+                }
+            }
+            if (buf.unassembled_bytes() != 100) {
+                throw runtime_error("expected 10 slices to be kept, not " + to_string(buf.unassembled_bytes()));
+            }
+
+            // a pooled chunk comes back to the pool once the caller lets go, though a slice of it is pending
+            string chunk = BufferPool::take();
+            chunk.assign(BufferPool::CHUNK_SIZE, 'y');
+            const char *storage = chunk.data();
+            {
+                Buffer datagram{move(chunk)};
+                datagram.remove_suffix(datagram.size() - 10);
+                buf.push_substring(move(datagram), 50, false);
+            }
+            if (BufferPool::take().data() != storage) {
+                throw runtime_error("a pending slice kept its whole received string alive");
+            }
+            if (buf.memory_footprint() > 10 * (OVERHEAD + 10)) {
+                throw runtime_error("footprint exceeds the budget");
+            }
+
+            // trimming the last slice to fit the budget copies it too
+            buf.set_memory_budget(10 * (OVERHEAD + 10) - 5);
+            buf.push_substring(string(50, 'x'), 0, false);
+            if (buf.stream_out().bytes_written() != 60 or buf.unassembled_bytes() != 85) {
+                throw runtime_error("slices were not kept or reassembled as expected");
+            }
+        }
+
+        // random fragments under a tight budget still reassemble once everything is resent
+        auto rd = get_random_generator();
+        for (const auto eviction : {StreamReassembler::Eviction::DropFarthest, StreamReassembler::Eviction::Coalesce}) {
+            for (unsigned rep_no = 0; rep_no < 32; ++rep_no) {
+                const size_t stream_len = 1 + rd() % 4000;
+                const size_t budget = rd() % (8 * OVERHEAD);
+                StreamReassembler buf{stream_len};
+                buf.set_memory_budget(budget, eviction);
+
+                string d(stream_len, 0);
+                generate(d.begin(), d.end(), [&] { return rd(); });
+                for (unsigned i = 0; i < 200; ++i) {
+                    const size_t index = rd() % stream_len;
+                    const size_t size = min<size_t>(rd() % 30, stream_len - index);
+                    buf.push_substring(d.substr(index, size), index, index + size == stream_len);
+                    if (buf.memory_footprint() > budget) {
+                        throw runtime_error("footprint exceeds the budget");
+                    }
+                }
+                for (size_t index = 0; index < stream_len; index += 100) {
+                    const size_t size = min<size_t>(100, stream_len - index);
+                    buf.push_substring(d.substr(index, size), index, index + size == stream_len);
+                }
+
+                if (buf.stream_out().read(stream_len) != d or not buf.stream_out().eof() or not buf.empty()) {
+                    throw runtime_error("stream not reassembled correctly after eviction");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -11,6 +11,13 @@
 #include <string>
 #include <utility>
 
+//! The engine under test; the build compiles each reassembler test a second time with `REASSEMBLER_ENGINE=Bitmap`
+#ifndef REASSEMBLER_ENGINE
+#define REASSEMBLER_ENGINE Intervals
+#endif
+
+constexpr StreamReassembler::Engine TEST_REASSEMBLER_ENGINE = StreamReassembler::Engine::REASSEMBLER_ENGINE;
+
 class ReassemblerExpectationViolation : public std::runtime_error {
   public:
     ReassemblerExpectationViolation(const std::string msg) : std::runtime_error(msg) {}
@@ -164,7 +171,7 @@ class ReassemblerTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
+    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity, TEST_REASSEMBLER_ENGINE), steps_executed() {
         steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
     }
 
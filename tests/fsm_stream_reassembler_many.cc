@@ -1,4 +1,5 @@
 #include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
 #include "stream_reassembler.hh"
 #include "util.hh"
 
@@ -28,7 +29,7 @@ int main() {
 
         // buffer a bunch of bytes, make sure we can empty and re-fill before calling close()
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{MAX_SEG_LEN * NSEGS};
+            StreamReassembler buf{MAX_SEG_LEN * NSEGS, TEST_REASSEMBLER_ENGINE};
 
             vector<tuple<size_t, size_t>> seq_size;
             size_t offset = 0;
@@ -58,7 +59,7 @@ int main() {
 
         // insert EOF into a hole in the buffer
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{65'000};
+            StreamReassembler buf{65'000, TEST_REASSEMBLER_ENGINE};
 
             const size_t size = 1024;
             string d(size, 0);
@@ -89,7 +90,7 @@ int main() {
 
         // insert EOF over previously queued data, require one of two possible correct actions
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{65'000};
+            StreamReassembler buf{65'000, TEST_REASSEMBLER_ENGINE};
 
             const size_t size = 1024;
             string d(size, 0);
@@ -0,0 +1,86 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+static constexpr unsigned NREPS = 64;
+static constexpr unsigned NSEGS = 512;
+static constexpr unsigned STREAM_LEN = 4096;
+static constexpr unsigned MAX_SEG_LEN = 300;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // random overlapping substrings against a byte-by-byte model of which indices are held
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            const size_t capacity = 1 + rd() % (2 * MAX_SEG_LEN);
+            StreamReassembler buf{capacity, TEST_REASSEMBLER_ENGINE};
+
+            string d(STREAM_LEN, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+
+            vector<bool> held(STREAM_LEN, false);
+            size_t assembled = 0;
+            string result;
+
+            for (unsigned i = 0; i < NSEGS or result.size() < STREAM_LEN; ++i) {
+                // keep the substrings near the window (some overlapping what is already assembled)
+                const size_t back = min<size_t>(assembled, rd() % MAX_SEG_LEN);
+                const size_t index = min<size_t>(assembled - back + rd() % (capacity + MAX_SEG_LEN), STREAM_LEN - 1);
+                const size_t size = min<size_t>(rd() % MAX_SEG_LEN, STREAM_LEN - index);
+                const bool eof = index + size == STREAM_LEN;
+                // exercise both the copying and the Buffer-sharing overloads
+                if (rd() % 2) {
+                    buf.push_substring(d.substr(index, size), index, eof);
+                } else {
+                    buf.push_substring(Buffer(d.substr(index, size)), index, eof);
+                }
+
+                const size_t window_end = buf.stream_out().bytes_read() + capacity;
+                for (size_t j = max(index, assembled); j < min(index + size, window_end); ++j) {
+                    held[j] = true;
+                }
+                while (assembled < STREAM_LEN and held[assembled]) {
+                    ++assembled;
+                }
+                const size_t expected_unassembled = count(held.begin() + assembled, held.end(), true);
+
+                if (buf.stream_out().bytes_written() != assembled) {
+                    throw runtime_error("assembled the wrong number of bytes");
+                }
+                if (buf.unassembled_bytes() != expected_unassembled) {
+                    throw runtime_error("unassembled_bytes() is " + to_string(buf.unassembled_bytes()) +
+                                        ", expected " + to_string(expected_unassembled));
+                }
+                if (buf.stream_out().input_ended() != (assembled == STREAM_LEN)) {
+                    throw runtime_error("input ended at the wrong time");
+                }
+
+                result.append(buf.stream_out().read(rd() % (buf.stream_out().buffer_size() + 1)));
+                if (result != d.substr(0, result.size())) {
+                    throw runtime_error("content of RX bytes is incorrect");
+                }
+            }
+
+            if (not buf.stream_out().eof() or not buf.empty()) {
+                throw runtime_error("stream did not finish");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,4 +1,5 @@
 #include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
 #include "stream_reassembler.hh"
 #include "util.hh"
 
@@ -28,7 +29,7 @@ int main() {
 
         // overlapping segments
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{NSEGS * MAX_SEG_LEN};
+            StreamReassembler buf{NSEGS * MAX_SEG_LEN, TEST_REASSEMBLER_ENGINE};
 
             vector<tuple<size_t, size_t>> seq_size;
             size_t offset = 0;
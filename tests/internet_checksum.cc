@@ -0,0 +1,130 @@
+#include "byte_stream.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+//! The one-byte-at-a-time definition every kernel must match
+static uint16_t reference_checksum(const uint32_t initial_sum, const string &data) {
+    uint64_t sum = initial_sum;
+    for (size_t i = 0; i < data.size(); i++) {
+        sum += i % 2 == 0 ? uint8_t(data[i]) << 8 : uint8_t(data[i]);
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (const auto kernel :
+             {InternetChecksum::Kernel::Portable, InternetChecksum::Kernel::SSE2, InternetChecksum::Kernel::AVX2}) {
+            if (not InternetChecksum::supported(kernel)) {
+                continue;
+            }
+            InternetChecksum::use(kernel);
+
+            for (unsigned rep = 0; rep < 2000; ++rep) {
+                // mostly short, odd and even lengths, with the occasional run of 0xff to stress the carries
+                string data(rep % 10 == 0 ? rd() % 70000 : rd() % 200, 0);
+                const bool saturated = rd() % 4 == 0;
+                generate(data.begin(), data.end(), [&] { return saturated ? 0xff : rd(); });
+                const uint32_t initial_sum = rd() % 3 == 0 ? 0 : rd();
+
+                // the same data in one call, and split at random byte boundaries (also copying it)
+                InternetChecksum whole{initial_sum}, pieces{initial_sum}, copied{initial_sum};
+                string copy(data.size(), 0);
+                whole.add(data);
+                for (size_t offset = 0; offset < data.size();) {
+                    const size_t len = min<size_t>(rd() % 40, data.size() - offset);
+                    pieces.add({data.data() + offset, len});
+                    copied.add_copy(copy.data() + offset, {data.data() + offset, len});
+                    offset += len;
+                }
+
+                const uint16_t expected = reference_checksum(initial_sum, data);
+                if (whole.value() != expected or pieces.value() != expected) {
+                    throw runtime_error("checksum of " + to_string(data.size()) + " bytes is " +
+                                        to_string(whole.value()) + " (whole) and " + to_string(pieces.value()) +
+                                        " (in pieces), expected " + to_string(expected));
+                }
+                if (copied.value() != expected or copy != data) {
+                    throw runtime_error("add_copy() of " + to_string(data.size()) + " bytes went wrong");
+                }
+            }
+        }
+
+        // partial sums combine
+        for (unsigned rep = 0; rep < 2000; ++rep) {
+            string data(2 * (2 + rd() % 100), 0);
+            generate(data.begin(), data.end(), [&] { return rd(); });
+            const size_t split = 2 * (rd() % (data.size() / 2));
+
+            InternetChecksum head, tail;
+            head.add(data.substr(0, split));
+            tail.add(data.substr(split));
+            head.add_sum(tail.sum());
+            const uint16_t checksum = head.value();
+            if (checksum != reference_checksum(0, data)) {
+                throw runtime_error("add_sum() does not match summing the bytes");
+            }
+        }
+
+        // peeking out of a stream sums the same bytes it returns, wherever the stream's pieces or wrap point lie
+        for (const auto storage : {ByteStream::Storage::Ring, ByteStream::Storage::Chunked}) {
+            ByteStream stream{3000, storage};
+            for (unsigned rep = 0; rep < 500; ++rep) {
+                string piece(rd() % 1500, 0);
+                generate(piece.begin(), piece.end(), [&] { return rd(); });
+                stream.write(piece);
+
+                InternetChecksum check;
+                const size_t len = rd() % 1600;
+                const Buffer peeked = stream.peek_summed(len, check);
+                if (peeked.str() != stream.peek_output(len) or
+                    check.value() != reference_checksum(0, stream.peek_output(len))) {
+                    throw runtime_error("peek_summed() returned or summed the wrong bytes");
+                }
+                stream.pop_output(peeked.size());
+            }
+        }
+
+        // a segment re-serialized after its header or payload changed still carries a valid checksum
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{12345};
+            seg.payload() = string("a payload of odd length");
+            for (unsigned i = 0; i < 4; ++i) {
+                if (i == 1) {
+                    seg.header().ackno = WrappingInt32{67890};
+                    seg.header().win = 1000;
+                } else if (i == 2) {
+                    seg.payload() = string("another payload, this one of even length");
+                } else if (i == 3) {
+                    seg.payload() = string{};
+                }
+
+                const uint32_t pseudo_sum = rd() % 0x40000;
+                TCPSegment parsed;
+                if (parsed.parse(seg.serialize(pseudo_sum).concatenate(), pseudo_sum) != ParseResult::NoError or
+                    parsed.payload().str() != seg.payload().str()) {
+                    throw runtime_error("re-serialized segment does not parse");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+#ifndef SPONGE_LOSSY_LINK_HARNESS_HH
+#define SPONGE_LOSSY_LINK_HARNESS_HH
+
+#include "fd_adapter.hh"
+#include "lossy_fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+//! \brief One direction of a bottleneck link: a drop-tail queue drained at a fixed rate, then a propagation delay
+class SimulatedLink {
+  public:
+    //! Shape of the link
+    struct Config {
+        size_t bytes_per_ms = 1000;   //!< Bottleneck rate (1000 bytes/ms is 8 Mbit/s)
+        uint64_t delay_ms = 10;       //!< One-way propagation delay
+        size_t queue_bytes = 20'000;  //!< Most bytes waiting for the bottleneck before arrivals are dropped
+    };
+
+    //! Bytes a segment occupies on the wire, counting 40 bytes of IPv4 and TCP headers
+    static size_t wire_size(const TCPSegment &seg) { return 40 + seg.payload().size(); }
+
+  private:
+    struct Propagating {
+        uint64_t arrival_ms;
+        TCPSegment seg;
+    };
+
+    Config _cfg;
+    std::deque<TCPSegment> _queue{};
+    size_t _queued_bytes{0};
+    std::deque<Propagating> _propagating{};
+    size_t _credit{0};  //!< Bytes the bottleneck may still send this millisecond
+    uint64_t _now{0};
+    size_t _drops{0};
+
+  public:
+    explicit SimulatedLink(const Config &cfg) : _cfg(cfg) {}
+
+    //! Enqueue a segment for the bottleneck, or drop it if the queue is full
+    void send(const TCPSegment &seg) {
+        const size_t size = wire_size(seg);
+        if (_queued_bytes + size > _cfg.queue_bytes) {
+            _drops++;
+            return;
+        }
+        _queued_bytes += size;
+        _queue.push_back(seg);
+    }
+
+    //! Let one millisecond pass
+    void advance() {
+        _now++;
+        _credit += _cfg.bytes_per_ms;
+        while (not _queue.empty() and _credit >= wire_size(_queue.front())) {
+            const size_t size = wire_size(_queue.front());
+            _credit -= size;
+            _queued_bytes -= size;
+            _propagating.push_back({_now + _cfg.delay_ms, std::move(_queue.front())});
+            _queue.pop_front();
+        }
+        if (_queue.empty()) {
+            _credit = 0;  // an idle link can't bank capacity for later
+        }
+    }
+
+    //! Has a segment reached the far end?
+    bool readable() const { return not _propagating.empty() and _propagating.front().arrival_ms <= _now; }
+
+    //! The next segment to reach the far end, if any has
+    std::optional<TCPSegment> receive() {
+        if (not readable()) {
+            return {};
+        }
+        TCPSegment seg = std::move(_propagating.front().seg);
+        _propagating.pop_front();
+        return seg;
+    }
+
+    size_t drops() const { return _drops; }  //!< Segments dropped because the queue was full
+};
+
+//! \brief An FdAdapter over a pair of SimulatedLinks, for wrapping in LossyFdAdapter
+class SimulatedLinkAdapter : public FdAdapterBase {
+  private:
+    SimulatedLink &_out;
+    SimulatedLink &_in;
+
+  public:
+    SimulatedLinkAdapter(SimulatedLink &out, SimulatedLink &in) : _out(out), _in(in) {}
+
+    std::optional<TCPSegment> read() { return _in.receive(); }
+    void write(TCPSegment &seg) { _out.send(seg); }
+};
+
+//! \brief Transfers a stream between two TCPConnections over simulated links, one millisecond at a time
+//! \details Segments cross a bottleneck (SimulatedLink) and may also be dropped at random by a LossyFdAdapter.
+class LossyLinkSimulation {
+  public:
+    //! What happened during a transfer
+    struct Result {
+        uint64_t duration_ms{0};   //!< Time until the receiver had the whole stream (zero if it never did)
+        size_t segments_sent{0};   //!< Segments the sending connection wrote, retransmissions included
+        size_t queue_drops{0};     //!< Segments dropped at the bottleneck queue
+        std::string received{};    //!< Stream delivered to the receiving application
+    };
+
+  private:
+    SimulatedLink _forward;
+    SimulatedLink _reverse;
+    TCPConnection _client;
+    TCPConnection _server;
+    LossyFdAdapter<SimulatedLinkAdapter> _client_adapter;
+    LossyFdAdapter<SimulatedLinkAdapter> _server_adapter;
+
+    //! Pass a connection's inbound segments to it, and its outbound segments to the link
+    static size_t exchange(TCPConnection &tcp, LossyFdAdapter<SimulatedLinkAdapter> &adapter, SimulatedLink &in) {
+        while (in.readable()) {
+            if (auto seg = adapter.read()) {
+                tcp.segment_received(*seg);
+            }
+        }
+        size_t sent = 0;
+        while (not tcp.segments_out().empty()) {
+            adapter.write(tcp.segments_out().front());
+            tcp.segments_out().pop();
+            sent++;
+        }
+        return sent;
+    }
+
+  public:
+    //! \param[in] cfg configures both connections
+    //! \param[in] link configures both directions of the link
+    //! \param[in] loss_rate probability (out of UINT16_MAX) that a segment is dropped at random, in either direction
+    //! \param[in] seed picks the random drops, so that runs with the same seed lose segments at the same draws
+    LossyLinkSimulation(const TCPConfig &cfg,
+                        const SimulatedLink::Config &link,
+                        const uint16_t loss_rate = 0,
+                        const uint32_t seed = 0)
+        : _forward(link)
+        , _reverse(link)
+        , _client(cfg)
+        , _server(cfg)
+        , _client_adapter(SimulatedLinkAdapter{_forward, _reverse})
+        , _server_adapter(SimulatedLinkAdapter{_reverse, _forward}) {
+        _client_adapter.config_mut().loss_rate_up = loss_rate;
+        _server_adapter.config_mut().loss_rate_up = loss_rate;
+        _client_adapter.seed(2 * seed);
+        _server_adapter.seed(2 * seed + 1);
+    }
+
+    //! \brief Send `data` from client to server, then close both connections
+    //! \returns what happened, once both connections have closed or `timeout_ms` has passed
+    Result transfer(const std::string &data, const uint64_t timeout_ms) {
+        Result result;
+        size_t written = 0;
+        bool delivered = false;
+        _client.connect();
+
+        for (uint64_t now = 0; now < timeout_ms and (_client.active() or _server.active()); now++) {
+            if (_client.active() and written < data.size()) {
+                written += _client.write(data.substr(written, _client.remaining_outbound_capacity()));
+                if (written == data.size()) {
+                    _client.end_input_stream();
+                }
+            }
+
+            result.segments_sent += exchange(_client, _client_adapter, _reverse);
+            exchange(_server, _server_adapter, _forward);
+
+            auto &inbound = _server.inbound_stream();
+            result.received += inbound.read(inbound.buffer_size());
+            if (inbound.eof() and not delivered) {
+                delivered = true;
+                result.duration_ms = now;
+                _server.end_input_stream();
+            }
+
+            _client.tick(1);
+            _server.tick(1);
+            _forward.advance();
+            _reverse.advance();
+        }
+
+        result.queue_drops = _forward.drops();
+        return result;
+    }
+};
+
+#endif  // SPONGE_LOSSY_LINK_HARNESS_HH
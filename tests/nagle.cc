@@ -0,0 +1,122 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_fixtures.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! Write `count` strings of `size` bytes, filling the window after each as TCPConnection::write does
+static void small_writes(TCPSender &sender, const unsigned count, const size_t size) {
+    for (unsigned i = 0; i < count; i++) {
+        sender.stream_in().write(string(size, 'x'));
+        sender.fill_window();
+    }
+}
+
+int main() {
+    try {
+        const WrappingInt32 isn{0};
+
+        // without Nagle, every write goes out at once
+        {
+            TCPSender sender = connected_sender(isn);
+            small_writes(sender, 50, 10);
+            test_err_if(sender.segments_out().size() != 50, "each small write should be its own segment");
+        }
+
+        // with it, writes made while data is in flight wait for the ack, then go out together
+        {
+            TCPSender sender = connected_sender(isn);
+            sender.set_nagle(true);
+            small_writes(sender, 50, 10);
+            test_err_if(sender.segments_out().size() != 1 or sender.segments_out().front().payload().size() != 10,
+                        "only the first small write should go out while it is unacknowledged");
+            sender.segments_out() = {};
+
+            sender.ack_received(isn + 11, 60000);
+            test_err_if(sender.segments_out().size() != 1 or sender.segments_out().front().payload().size() != 490,
+                        "the ack should release the held writes as one segment");
+            sender.segments_out() = {};
+
+            // a full segment's worth isn't held back, but the remainder is
+            small_writes(sender, 150, 10);
+            test_err_if(sender.segments_out().size() != 1 or sender.segments_out().front().payload().size() != 1000,
+                        "a full segment should go out even with data in flight");
+            test_err_if(sender.stream_in().buffer_size() != 500, "a partial segment went out with data in flight");
+            sender.segments_out() = {};
+
+            // the end of the stream isn't held back either
+            sender.stream_in().end_input();
+            sender.fill_window();
+            test_err_if(sender.segments_out().size() != 1 or not sender.segments_out().front().header().fin or
+                            sender.segments_out().front().payload().size() != 500,
+                        "the tail of the stream should go out with the FIN");
+        }
+
+        // a sliver of window is held back too, while data is in flight
+        {
+            TCPSender sender = connected_sender(isn, 1500);
+            sender.set_nagle(true);
+            sender.stream_in().write(string(3000, 'x'));
+            sender.fill_window();
+            test_err_if(sender.segments_out().size() != 1 or sender.bytes_in_flight() != 1000,
+                        "a 500-byte sliver of window was used while a segment was in flight");
+            sender.segments_out() = {};
+            sender.ack_received(isn + 1001, 1500);
+            test_err_if(sender.segments_out().size() != 1 or sender.segments_out().front().payload().size() != 1000,
+                        "the ack should release one full segment");
+        }
+
+        // whole connections: small writes coalesce, and the stream still arrives intact
+        {
+            TCPConfig cfg;
+            cfg.nodelay = false;
+            TCPConnection client{cfg}, server{cfg};
+            client.connect();
+
+            const auto exchange = [&] {
+                size_t segments = 0;
+                while (not client.segments_out().empty() or not server.segments_out().empty()) {
+                    segments += deliver(client, server);
+                    deliver(server, client);
+                }
+                return segments;
+            };
+            exchange();
+
+            // each batch of writes is one round trip: the first write goes out, the rest after its ack
+            string sent;
+            size_t segments = 0;
+            for (unsigned batch = 0; batch < 10; batch++) {
+                for (unsigned i = 0; i < 20; i++) {
+                    const string data(10, char('a' + batch));
+                    client.write(data);
+                    sent += data;
+                }
+                segments += exchange();
+            }
+            test_err_if(server.inbound_stream().read(sent.size()) != sent, "stream was not delivered intact");
+            test_err_if(segments != 20, "each batch of small writes should take two segments");
+
+            client.end_input_stream();
+            exchange();
+            server.end_input_stream();
+            exchange();
+            client.tick(10 * cfg.rt_timeout);
+            test_err_if(client.active() or server.active(), "connections didn't close");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
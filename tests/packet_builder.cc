@@ -0,0 +1,107 @@
+#include "address.hh"
+#include "buffer.hh"
+#include "fd_adapter.hh"
+#include "ipv4_datagram.hh"
+#include "socket.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // headers can't grow past the headroom
+        {
+            PacketBuilder packet{"payload", 8};
+            packet.prepend(5);
+            packet.prepend(3);
+            bool threw = false;
+            try {
+                packet.prepend(1);
+            } catch (const length_error &) {
+                threw = true;
+            }
+            if (not threw or packet.finish().str() != string(8, 0) + "payload") {
+                throw runtime_error("PacketBuilder headroom not enforced");
+            }
+        }
+
+        TCPOverIPv4Adapter adapter;
+        for (unsigned rep = 0; rep < 5000; ++rep) {
+            const auto random_address = [&] {
+                return Address{Address::from_ipv4_numeric(rd()).ip(), static_cast<uint16_t>(rd())};
+            };
+            adapter.config_mut().source = random_address();
+            adapter.config_mut().destination = random_address();
+
+            TCPSegment seg;
+            TCPHeader &header = seg.header();
+            header.seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+            header.ackno = WrappingInt32{static_cast<uint32_t>(rd())};
+            header.doff = 5 + rd() % 11;
+            header.ack = rd() % 2;
+            header.syn = rd() % 2;
+            header.fin = rd() % 2;
+            header.win = rd();
+            header.cksum = rd();  // ignored: the checksum is always computed
+            string payload(rd() % 1500, 0);
+            generate(payload.begin(), payload.end(), [&] { return rd(); });
+            seg.payload() = move(payload);
+
+            const string expected = adapter.wrap_tcp_in_ip(seg).serialize().concatenate();
+            const Buffer packet = adapter.serialize_tcp_in_ip(seg);
+            if (packet.str() != expected) {
+                throw runtime_error("packet built in place differs from the wrapped datagram");
+            }
+
+            // both checksums come out right
+            InternetDatagram ip_dgram;
+            if (ip_dgram.parse(packet) != ParseResult::NoError) {
+                throw runtime_error("built packet is not a valid IPv4 datagram");
+            }
+            TCPSegment parsed;
+            if (parsed.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum()) != ParseResult::NoError) {
+                throw runtime_error("built packet does not carry a valid TCP segment");
+            }
+            if (parsed.header().seqno != header.seqno or parsed.header().doff != header.doff or
+                parsed.payload().str() != seg.payload().str()) {
+                throw runtime_error("built packet decoded to a different segment");
+            }
+        }
+
+        // sending a segment over UDP hands the packet's chunk back to the pool
+        {
+            UDPSocket peer;
+            peer.bind(Address{"127.0.0.1", 0});
+            TCPOverUDPSocketAdapter udp_adapter{UDPSocket{}};
+            udp_adapter.config_mut().destination = peer.local_address();
+            TCPSegment seg;
+            seg.payload() = string(100, 'x');
+
+            string chunk = BufferPool::take();
+            const char *storage = chunk.data();
+            BufferPool::recycle(move(chunk));
+            udp_adapter.write(seg);
+            if (BufferPool::take().data() != storage) {
+                throw runtime_error("the UDP adapter didn't recycle its packet");
+            }
+            if (peer.recv().payload.size() != 4 * size_t{seg.header().doff} + 100) {
+                throw runtime_error("the UDP adapter sent the wrong packet");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -128,6 +128,19 @@ int main() {
             test.execute(ExpectBytes{std::move(all_data)});
         }
 
+        // a chunked inbound stream keeps an in-order payload's own storage
+        for (const auto storage : {ByteStream::Storage::Ring, ByteStream::Storage::Chunked}) {
+            TCPReceiver receiver{4000, storage};
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.payload() = Buffer{string(100, 'x')};
+            receiver.segment_received(seg);
+            const bool shared = receiver.stream_out().peek_views(100).as_iovecs().front().iov_base ==
+                                seg.payload().str().data();
+            if (receiver.stream_out().buffer_size() != 100 or shared != (storage == ByteStream::Storage::Chunked)) {
+                throw runtime_error("only a chunked inbound stream should share the payload");
+            }
+        }
     } catch (const exception &e) {
         cerr << e.what() << endl;
         return 1;
@@ -0,0 +1,43 @@
+#ifndef SPONGE_TESTS_TCP_FIXTURES_HH
+#define SPONGE_TESTS_TCP_FIXTURES_HH
+
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_sender.hh"
+#include "wrapping_integers.hh"
+
+#include <cstddef>
+#include <string>
+
+//! A TCPSender with 1000-byte segments whose SYN has been acked with a `window`-byte window, with nothing queued
+inline TCPSender connected_sender(const WrappingInt32 isn, const size_t window = 60000) {
+    TCPSender sender{TCPConfig::DEFAULT_CAPACITY, 1000, isn};
+    sender.fill_window();
+    sender.ack_received(isn + 1, window);
+    sender.segments_out() = {};
+    return sender;
+}
+
+//! Write `data` to the sender's stream and send what the window allows, discarding the segments sent
+//! \returns how many segments were sent
+inline size_t write_and_send(TCPSender &sender, const std::string &data) {
+    sender.stream_in().write(data);
+    sender.fill_window();
+    const size_t sent = sender.segments_out().size();
+    sender.segments_out() = {};
+    return sent;
+}
+
+//! Move every queued segment from `from` to `to`
+//! \returns how many segments were moved
+inline size_t deliver(TCPConnection &from, TCPConnection &to) {
+    size_t delivered = 0;
+    while (not from.segments_out().empty()) {
+        to.segment_received(from.segments_out().front());
+        from.segments_out().pop();
+        delivered++;
+    }
+    return delivered;
+}
+
+#endif  // SPONGE_TESTS_TCP_FIXTURES_HH
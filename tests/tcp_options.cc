@@ -0,0 +1,219 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Serialize and parse a segment, as the network between two connections would
+static TCPSegment over_the_wire(const TCPSegment &seg) {
+    TCPSegment parsed;
+    if (parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError) {
+        throw runtime_error("segment did not survive the wire");
+    }
+    return parsed;
+}
+
+//! Deliver every segment `from` has queued to `to`, calling `inspect` on each; \returns how many there were
+template <typename Inspect>
+static size_t deliver(TCPConnection &from, TCPConnection &to, Inspect &&inspect) {
+    size_t delivered = 0;
+    while (not from.segments_out().empty()) {
+        const TCPSegment seg = over_the_wire(from.segments_out().front());
+        from.segments_out().pop();
+        inspect(seg);
+        to.segment_received(seg);
+        delivered++;
+    }
+    return delivered;
+}
+
+static void check_codec() {
+    auto rd = get_random_generator();
+    for (unsigned rep = 0; rep < 1000; ++rep) {
+        TCPSegment seg;
+        TCPOptions &options = seg.header().options;
+        if (rd() % 2) {
+            options.mss = rd();
+        }
+        if (rd() % 2) {
+            options.window_scale = rd() % (TCPOptions::MAX_WINDOW_SCALE + 1);
+        }
+        if (rd() % 2) {
+            options.timestamps = TCPOptions::Timestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+        }
+        seg.header().fit_options();
+        seg.header().syn = true;
+        seg.payload() = string(rd() % 100, 'x');
+
+        const TCPSegment parsed = over_the_wire(seg);
+        if (not(parsed.header() == seg.header()) or parsed.payload().str() != seg.payload().str()) {
+            throw runtime_error("options did not round-trip");
+        }
+    }
+
+    // unknown options and NOPs are skipped; parsing stops at a malformed option
+    TCPOptions options;
+    options.parse(string("\x04\x02\x01\x02\x04\x05\xb4\x03\x03\x20\x08\x00\x03\x03\x01", 15));
+    if (options.mss != 1460 or options.window_scale != TCPOptions::MAX_WINDOW_SCALE or options.timestamps) {
+        throw runtime_error("options parsed incorrectly");
+    }
+
+    TCPHeader header;
+    header.options.mss = 1460;
+    bool threw = false;
+    try {
+        header.serialize();
+    } catch (const runtime_error &) {
+        threw = true;
+    }
+    if (not threw) {
+        throw runtime_error("options that don't fit in the header were serialized");
+    }
+}
+
+//! Open a connection between `client_cfg` and `server_cfg` and send `bytes` bytes from client to server
+static void check_connection(const TCPConfig &client_cfg, const TCPConfig &server_cfg, const size_t bytes) {
+    TCPConnection client{client_cfg}, server{server_cfg};
+    const bool window_scaling = client_cfg.window_scaling and server_cfg.window_scaling;
+    const bool timestamps = client_cfg.timestamps and server_cfg.timestamps;
+    const size_t mss = min(client_cfg.mss, server_cfg.mss);
+
+    client.connect();
+    deliver(client, server, [&](const TCPSegment &syn) {
+        if (syn.header().options.mss != client_cfg.mss or
+            syn.header().options.window_scale.has_value() != client_cfg.window_scaling or
+            syn.header().options.timestamps.has_value() != client_cfg.timestamps) {
+            throw runtime_error("SYN does not offer the configured options");
+        }
+    });
+    deliver(server, client, [&](const TCPSegment &syn_ack) {
+        if (syn_ack.header().options.window_scale.has_value() != window_scaling or
+            syn_ack.header().options.timestamps.has_value() != timestamps) {
+            throw runtime_error("SYN-ACK offers options the SYN did not");
+        }
+        if (syn_ack.header().win != min<size_t>(server_cfg.recv_capacity, UINT16_MAX)) {
+            throw runtime_error("SYN-ACK window was scaled");
+        }
+    });
+    deliver(client, server, [](const TCPSegment &) {});
+
+    string data(bytes, 0);
+    auto rd = get_random_generator();
+    generate(data.begin(), data.end(), [&] { return rd(); });
+
+    size_t written = 0, most_in_flight = 0;
+    string received;
+    while (received.size() < bytes) {
+        written += client.write(data.substr(written, client.remaining_outbound_capacity()));
+        most_in_flight = max(most_in_flight, client.bytes_in_flight());
+        deliver(client, server, [&](const TCPSegment &seg) {
+            if (seg.payload().size() > mss) {
+                throw runtime_error("segment exceeds the negotiated MSS");
+            }
+            if (seg.header().options.timestamps.has_value() != timestamps) {
+                throw runtime_error("data segment timestamps don't match the negotiation");
+            }
+        });
+        received += server.inbound_stream().read(server.inbound_stream().buffer_size());
+        deliver(server, client, [](const TCPSegment &) {});
+    }
+
+    if (received != data) {
+        throw runtime_error("stream corrupted");
+    }
+    // without window scaling, the server can't advertise more than 64 KiB
+    if (window_scaling != (most_in_flight > UINT16_MAX)) {
+        throw runtime_error("saw up to " + to_string(most_in_flight) + " bytes in flight");
+    }
+
+    // close from the client, then the server, and let the client's linger time out
+    client.end_input_stream();
+    deliver(client, server, [](const TCPSegment &) {});
+    deliver(server, client, [](const TCPSegment &) {});
+    server.end_input_stream();
+    deliver(server, client, [](const TCPSegment &) {});
+    deliver(client, server, [](const TCPSegment &) {});
+    client.tick(10 * client_cfg.rt_timeout);
+    if (client.active() or server.active()) {
+        throw runtime_error("connection did not close");
+    }
+}
+
+//! While a segment is missing, acks echo the TSval of the segment that last advanced the left edge
+static void check_ts_recent() {
+    TCPConfig cfg;
+    TCPConnection client{cfg}, server{cfg};
+    client.connect();
+    deliver(client, server, [](const TCPSegment &) {});
+    deliver(server, client, [](const TCPSegment &) {});
+    deliver(client, server, [](const TCPSegment &) {});
+
+    // two segments sent 10 ms apart; the first is delayed
+    client.tick(10);
+    client.write(string(cfg.mss, 'a'));
+    const TCPSegment first = over_the_wire(client.segments_out().front());
+    client.segments_out().pop();
+    client.tick(10);
+    client.write(string(cfg.mss, 'b'));
+
+    const auto echoed = [&] { return server.segments_out().back().header().options.timestamps.value().echo_reply; };
+    deliver(client, server, [](const TCPSegment &) {});
+    if (server.segments_out().empty() or echoed() != 0) {
+        throw runtime_error("an ack sent while a segment was missing echoed the out-of-order segment's TSval");
+    }
+    server.segments_out() = {};
+
+    server.segment_received(first);
+    if (server.segments_out().empty() or echoed() != first.header().options.timestamps.value().value) {
+        throw runtime_error("the segment that filled the hole didn't update TS.Recent");
+    }
+
+    deliver(server, client, [](const TCPSegment &) {});
+    client.end_input_stream();
+    deliver(client, server, [](const TCPSegment &) {});
+    server.end_input_stream();
+    deliver(server, client, [](const TCPSegment &) {});
+    deliver(client, server, [](const TCPSegment &) {});
+    client.tick(10 * cfg.rt_timeout);
+    if (client.active() or server.active()) {
+        throw runtime_error("connection did not close");
+    }
+}
+
+int main() {
+    try {
+        check_codec();
+        check_ts_recent();
+
+        TCPConfig big;
+        big.recv_capacity = 4 << 20;
+        big.send_capacity = 4 << 20;
+        big.mss = 1460;
+
+        // both sides scale: the whole 4 MiB window is usable
+        check_connection(big, big, 16 << 20);
+
+        // one side doesn't offer window scaling or timestamps: windows are capped at 64 KiB
+        TCPConfig plain = big;
+        plain.window_scaling = false;
+        plain.timestamps = false;
+        plain.mss = 536;
+        check_connection(big, plain, 1 << 20);
+        check_connection(plain, big, 1 << 20);
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_fixtures.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        // the RFC 6298 arithmetic
+        {
+            RTTEstimator rtt{1000, 50, 60000};
+            test_err_if(rtt.rto() != 1000, "RTO before any sample should be the initial one");
+            rtt.sample(100);
+            const auto stats = rtt.stats();
+            test_err_if(stats.srtt != 100 or stats.rttvar != 50 or stats.rto != 300 or stats.samples != 1,
+                        "first sample should set SRTT = R, RTTVAR = R/2, RTO = SRTT + 4 * RTTVAR");
+            for (unsigned i = 0; i < 100; i++) {
+                rtt.sample(100);
+            }
+            test_err_if(rtt.stats().srtt != 100 or rtt.rto() != 101, "steady samples should shrink RTO to SRTT + G");
+            rtt.sample(200000);
+            test_err_if(rtt.rto() != 60000, "RTO should be capped at its maximum");
+
+            RTTEstimator bounded{1000, 200, 60000};
+            bounded.sample(1);
+            test_err_if(bounded.rto() != 200, "RTO should be at least its minimum");
+        }
+
+        // the sender times segments, and skips retransmitted ones (Karn's algorithm)
+        {
+            const WrappingInt32 isn{0};
+            TCPSender sender{TCPConfig::DEFAULT_CAPACITY, 1000, isn};
+            sender.set_adaptive_rto(10, 60000);
+            sender.fill_window();
+            sender.segments_out() = {};
+            sender.tick(40);
+            sender.ack_received(isn + 1, 10000);
+            test_err_if(sender.rtt_stats().samples != 1 or sender.rtt_stats().srtt != 40,
+                        "SYN round trip not measured");
+            test_err_if(sender.rtt_stats().rto != 120, "RTO should follow the measured round trip");
+
+            sender.stream_in().write("hello");
+            sender.fill_window();
+            sender.segments_out() = {};
+            sender.tick(119);
+            test_err_if(not sender.segments_out().empty(), "retransmitted before the adaptive RTO");
+            sender.tick(1);
+            test_err_if(sender.segments_out().size() != 1, "no retransmission at the adaptive RTO");
+
+            sender.tick(5);
+            sender.ack_received(isn + 6, 10000);
+            test_err_if(sender.rtt_stats().samples != 1, "a retransmitted segment was timed");
+        }
+
+        // echoed timestamps from the future, or from before the acked segment was sent, aren't round trips
+        {
+            const WrappingInt32 isn{0};
+            TCPSender sender{TCPConfig::DEFAULT_CAPACITY, 1000, isn};
+            sender.set_adaptive_rto(10, 60000);
+            sender.tick(100);
+            sender.fill_window();
+            sender.tick(40);
+            sender.ack_received(isn + 1, 10000, 141);
+            test_err_if(sender.rtt_stats().samples != 0 or sender.rtt_stats().rto != 1000,
+                        "an echo from the future was timed");
+
+            sender.stream_in().write("hello");
+            sender.fill_window();
+            sender.tick(20);
+            sender.ack_received(isn + 6, 10000, 50);
+            test_err_if(sender.rtt_stats().samples != 0, "an echo from before the segment was sent was timed");
+
+            sender.stream_in().write("world");
+            sender.fill_window();
+            sender.tick(30);
+            sender.ack_received(isn + 11, 10000, 160);
+            test_err_if(sender.rtt_stats().samples != 1 or sender.rtt_stats().srtt != 30, "a valid echo was not timed");
+        }
+
+        // with a fixed RTO, round trips are still measured but don't change the timeout
+        {
+            const WrappingInt32 isn{0};
+            TCPSender sender{TCPConfig::DEFAULT_CAPACITY, 1000, isn};
+            sender.fill_window();
+            sender.tick(40);
+            sender.ack_received(isn + 1, 10000);
+            sender.stream_in().write("hello");
+            sender.fill_window();
+            sender.segments_out() = {};
+            sender.tick(999);
+            test_err_if(sender.rtt_stats().samples != 1 or not sender.segments_out().empty(), "fixed RTO was adapted");
+        }
+
+        // connections time round trips from echoed timestamps
+        {
+            TCPConfig cfg;
+            cfg.adaptive_rto = true;
+            TCPConnection client{cfg}, server{cfg};
+            client.connect();
+            deliver(client, server);
+            client.tick(25);
+            deliver(server, client);
+            test_err_if(client.rtt_stats().samples != 1 or client.rtt_stats().srtt != 25, "SYN-ACK echo not timed");
+
+            server.tick(7);
+            deliver(client, server);
+            test_err_if(server.rtt_stats().samples != 1 or server.rtt_stats().srtt != 7, "ACK echo not timed");
+
+            for (unsigned i = 0; i < 20; i++) {
+                client.write(string(100, 'x'));
+                client.tick(3);
+                server.tick(3);
+                deliver(client, server);
+                client.tick(3);
+                deliver(server, client);
+                server.inbound_stream().read(100);
+            }
+            test_err_if(client.rtt_stats().samples != 21, "data round trips not timed");
+            test_err_if(client.rtt_stats().srtt >= 10 or client.rtt_stats().rto != cfg.min_rto,
+                        "short round trips should bring the RTO down to its minimum");
+
+            client.end_input_stream();
+            deliver(client, server);
+            deliver(server, client);
+            server.end_input_stream();
+            deliver(server, client);
+            deliver(client, server);
+            client.tick(10 * cfg.rt_timeout);
+            test_err_if(client.active() or server.active(), "connection did not close");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+#include "lossy_link_harness.hh"
+#include "stream_reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_fixtures.hh"
+#include "tcp_header.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! A segment carrying `payload` at absolute seqno `seqno` (SYN at seqno 0)
+static TCPSegment data_segment(const WrappingInt32 isn, const uint64_t seqno, const string &payload) {
+    TCPSegment seg;
+    seg.header().seqno = wrap(seqno, isn);
+    seg.header().syn = seqno == 0;
+    seg.payload() = string(payload);
+    return seg;
+}
+
+int main() {
+    try {
+        const WrappingInt32 isn{0xfffffff0};  // so that the blocks wrap around
+
+        // the options survive a round trip through the wire format, within the 40 bytes of option space
+        {
+            TCPSegment seg;
+            TCPOptions &options = seg.header().options;
+            options.timestamps = TCPOptions::Timestamps{1, 2};
+            test_err_if(options.sack_capacity() != 3, "three SACK blocks should fit alongside timestamps");
+            for (uint32_t i = 0; i < options.sack_capacity(); i++) {
+                options.sack.push_back({isn + 1000 * i, isn + 1000 * i + 500});
+            }
+            seg.header().fit_options();
+            test_err_if(seg.header().doff != 15, "a header with timestamps and three SACK blocks should be 60 bytes");
+
+            TCPSegment parsed;
+            test_err_if(parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError,
+                        "SACK segment didn't parse");
+            test_err_if(not(parsed.header().options == options), "SACK blocks changed in a round trip");
+
+            TCPOptions syn_options;
+            syn_options.mss = 1460;
+            syn_options.sack_permitted = true;
+            test_err_if(syn_options.sack_capacity() != 3,
+                        "three SACK blocks should fit alongside MSS and SACK-permitted");
+            TCPOptions plain;
+            test_err_if(plain.sack_capacity() != TCPOptions::MAX_SACK_BLOCKS,
+                        "four SACK blocks should fit on their own");
+        }
+
+        // both reassembler engines report the runs they hold beyond the first gap
+        for (const auto engine : {StreamReassembler::Engine::Intervals, StreamReassembler::Engine::Bitmap}) {
+            StreamReassembler reassembler{100, engine};
+            test_err_if(not reassembler.pending_ranges().empty(), "an empty reassembler has no pending ranges");
+            reassembler.push_substring("0123", 0, false);
+            reassembler.push_substring("abcde", 5, false);
+            reassembler.push_substring("fg", 10, false);
+            reassembler.push_substring("xyz", 70, false);
+            const vector<pair<uint64_t, uint64_t>> expected = {{5, 12}, {70, 73}};
+            test_err_if(reassembler.pending_ranges() != expected, "wrong pending ranges");
+            reassembler.push_substring("4", 4, false);
+            const vector<pair<uint64_t, uint64_t>> remaining = {{70, 73}};
+            test_err_if(reassembler.pending_ranges() != remaining, "assembled bytes are still reported as pending");
+        }
+
+        // the receiver's first block holds the latest arrival, and the rest follow in order
+        {
+            TCPReceiver receiver{10000};
+            receiver.segment_received(data_segment(isn, 0, ""));
+            test_err_if(not receiver.sack_blocks(4).empty(), "SACK blocks without out-of-order data");
+            receiver.segment_received(data_segment(isn, 11, "aaaaa"));
+            receiver.segment_received(data_segment(isn, 31, "bbbbb"));
+            receiver.segment_received(data_segment(isn, 51, "ccccc"));
+            receiver.segment_received(data_segment(isn, 36, "ddddd"));
+            const auto blocks = receiver.sack_blocks(4);
+            test_err_if(blocks.size() != 3, "wrong number of SACK blocks");
+            test_err_if(blocks[0].left != isn + 31 or blocks[0].right != isn + 41,
+                        "first SACK block should hold the latest arrival, merged with its neighbour");
+            test_err_if(blocks[1].left != isn + 11 or blocks[1].right != isn + 16 or blocks[2].left != isn + 51,
+                        "later SACK blocks should be in ascending order");
+            test_err_if(receiver.sack_blocks(2).size() != 2, "too many SACK blocks");
+        }
+
+        // the sender resends only the segments the SACK blocks show are missing
+        {
+            TCPSender sender = connected_sender(isn);
+            sender.set_fast_retransmit(true);
+            write_and_send(sender, string(10000, 'x'));
+
+            // segments at 1001 and 4001 are lost; the others arrive and are SACKed one by one
+            vector<TCPOptions::SackBlock> blocks;
+            for (const uint32_t arrived : {2001, 3001, 5001, 6001}) {
+                if (blocks.empty() or arrived != blocks.back().right.raw_value() - isn.raw_value()) {
+                    blocks.push_back({isn + arrived, isn + arrived});
+                }
+                blocks.back().right = isn + arrived + 1000;
+                sender.sack_received(blocks);
+                sender.ack_received(isn + 1001, 60000);
+            }
+            set<uint32_t> resent;
+            while (not sender.segments_out().empty()) {
+                resent.insert(sender.segments_out().front().header().seqno - isn);
+                sender.segments_out().pop();
+            }
+            const set<uint32_t> holes = {1001, 4001};
+            test_err_if(resent != holes, "the SACK scoreboard should resend exactly the holes");
+
+            // the retransmission of 1001 fills the first hole: the partial ack resends nothing new
+            sender.ack_received(isn + 4001, 60000);
+            test_err_if(not sender.segments_out().empty(), "a hole was resent twice in one recovery");
+            sender.ack_received(isn + 10001, 60000);
+            test_err_if(sender.in_recovery() or sender.bytes_in_flight() != 0, "recovery didn't end");
+        }
+
+        // over a lossy link, SACK spares recovery the timeouts NewReno needs when a window loses several segments
+        {
+            auto rd = get_random_generator();
+            string data(1'000'000, 0);
+            generate(data.begin(), data.end(), [&] { return rd(); });
+
+            uint64_t duration[2] = {};
+            for (const bool sack : {false, true}) {
+                TCPConfig cfg;
+                cfg.recv_capacity = 1 << 20;
+                cfg.adaptive_rto = true;
+                cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+                cfg.sack = sack;
+
+                for (uint32_t seed = 0; seed < 5; seed++) {
+                    // about 3% random loss in each direction, drawn the same way with and without SACK
+                    LossyLinkSimulation simulation{cfg, SimulatedLink::Config{}, 2000, seed};
+                    const auto result = simulation.transfer(data, 600'000);
+                    test_err_if(result.received != data, "stream was not delivered intact");
+                    duration[sack] += result.duration_ms;
+                }
+            }
+            test_err_if(duration[true] >= duration[false], "SACK didn't speed up a lossy transfer");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (unsigned rep = 0; rep < 5000; ++rep) {
+            TCPSegment original;
+            TCPHeader &header = original.header();
+            header.sport = rd();
+            header.dport = rd();
+            header.seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+            header.ackno = WrappingInt32{static_cast<uint32_t>(rd())};
+            header.urg = rd() % 2;
+            header.ack = rd() % 2;
+            header.psh = rd() % 2;
+            header.rst = rd() % 2;
+            header.syn = rd() % 2;
+            header.fin = rd() % 2;
+            header.win = rd();
+            header.uptr = rd();
+            string payload(rd() % 100, 0);
+            generate(payload.begin(), payload.end(), [&] { return rd(); });
+            original.payload() = move(payload);
+
+            const uint32_t pseudo_sum = rd() % 0x40000;
+            string wire = original.serialize(pseudo_sum).concatenate();
+
+            // damage some of the segments, the way the network might
+            const unsigned damage = rd() % 4;
+            if (damage == 1) {
+                wire[rd() % wire.size()] ^= 1 + rd() % 255;
+            } else if (damage == 2) {
+                wire.resize(rd() % wire.size());
+            } else if (damage == 3) {
+                wire[12] = (rd() % 5) << 4;
+            }
+
+            TCPSegment parsed;
+            const ParseResult expected = parsed.parse(string(wire), pseudo_sum);
+
+            const TCPSegmentView view{Buffer(string(wire))};
+            ParseResult result = view.validate();
+            if (result == ParseResult::NoError and not view.checksum_ok(pseudo_sum)) {
+                result = ParseResult::BadChecksum;
+            }
+            // TCPSegment::parse checks the checksum first, so it reports BadChecksum for any damage
+            const bool both_rejected = expected == ParseResult::BadChecksum and result != ParseResult::NoError;
+            if (result != expected and not both_rejected) {
+                throw runtime_error("view found " + as_string(result) + ", but TCPSegment::parse found " +
+                                    as_string(expected));
+            }
+            if (result != ParseResult::NoError) {
+                continue;
+            }
+
+            const TCPSegment decoded = view.segment();
+            if (not(decoded.header() == parsed.header()) or decoded.payload().str() != parsed.payload().str()) {
+                throw runtime_error("view decoded a different segment than TCPSegment::parse");
+            }
+            if (view.sport() != header.sport or view.seqno() != header.seqno or view.syn() != header.syn or
+                view.fin() != header.fin or view.win() != header.win) {
+                throw runtime_error("view decoded the wrong header fields");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}